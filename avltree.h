@@ -0,0 +1,391 @@
+#ifndef AVLTREE_H
+#define AVLTREE_H
+#include <functional>
+#include <memory>
+#include <utility>
+using namespace std;
+
+// bound on the length of a root-to-leaf path; an AVL tree of n nodes is at most ~1.44*log2(n) tall
+const int MAXDEPTH = 64;
+
+// the AVL balancing, written once against Links, which says how to reach a node. Links::Ref names a node (a pointer,
+// or an index into a pool), Links::none() is the Ref of an empty subtree, left and right return the child links
+// themselves so a rotation can assign to them, height is -1 for none, and augment recomputes whatever a node keeps
+// about its subtree from its children. AvlBalance is the Links of nodes linked by pointers, CompactStreak has one for
+// its pool
+template <class Links>
+class AvlRotations{
+public:
+    typedef typename Links::Ref Ref;
+    explicit AvlRotations(const Links &links = Links()) : m_links(links){}
+
+    // left child height minus right child height
+    int checkImbalance(Ref aNode) const{
+        return m_links.height(m_links.left(aNode)) - m_links.height(m_links.right(aNode));
+    }
+
+    // updates the height and the augmentation of a node whose children are up to date
+    void update(Ref aNode) const{
+        int left = m_links.height(m_links.left(aNode));
+        int right = m_links.height(m_links.right(aNode));
+        m_links.setHeight(aNode, (left > right ? left : right) + 1);
+        m_links.augment(aNode);
+    }
+
+    // rebalances an imbalanced node and returns the root of its subtree, none for an empty one
+    Ref rebalance(Ref aNode) const{
+        if (aNode == Links::none()){
+            return aNode;
+        }
+        int imbalance = checkImbalance(aNode);
+        if (imbalance > 1){
+            // the left child leans the same way or not at all, one rotation does
+            if (checkImbalance(m_links.left(aNode)) >= 0){
+                return singleRight(aNode);
+            }
+            return leftRight(aNode);
+        }else if (imbalance < -1){
+            if (checkImbalance(m_links.right(aNode)) <= 0){
+                return singleLeft(aNode);
+            }
+            return rightLeft(aNode);
+        }
+        return aNode;
+    }
+
+    // single left rotation
+    Ref singleLeft(Ref z) const{
+        Ref y = m_links.right(z);
+        m_links.right(z) = m_links.left(y);
+        m_links.left(y) = z;
+        update(z);
+        update(y);
+        return y;
+    }
+
+    // single right rotation
+    Ref singleRight(Ref z) const{
+        Ref y = m_links.left(z);
+        m_links.left(z) = m_links.right(y);
+        m_links.right(y) = z;
+        update(z);
+        update(y);
+        return y;
+    }
+
+    // double left right rotation
+    Ref leftRight(Ref z) const{
+        Ref y = m_links.left(z);
+        Ref x = m_links.right(y);
+        m_links.left(z) = m_links.right(x);
+        m_links.right(x) = z;
+        m_links.right(y) = m_links.left(x);
+        m_links.left(x) = y;
+        update(z);
+        update(y);
+        update(x);
+        return x;
+    }
+
+    // double right left rotation
+    Ref rightLeft(Ref z) const{
+        Ref y = m_links.right(z);
+        Ref x = m_links.left(y);
+        m_links.right(z) = m_links.left(x);
+        m_links.left(x) = z;
+        m_links.left(y) = m_links.right(x);
+        m_links.right(x) = y;
+        update(z);
+        update(y);
+        update(x);
+        return x;
+    }
+
+    // walks a recorded descent bottom-up. path[i] is the link (parent's child link or the root) that held the i-th
+    // node. heights are updated and nodes rebalanced until a subtree comes out with its old height, above that only
+    // the augmentation can still change. returns the # of nodes visited
+    int retrace(Ref *path[], int depth) const{
+        int visited = 0;
+        while (depth > 0){
+            Ref *link = path[--depth];
+            int oldHeight = m_links.height(*link);
+            visited++;
+            update(*link);
+            *link = rebalance(*link);
+            if (m_links.height(*link) == oldHeight){
+                break;
+            }
+        }
+        while (depth > 0){
+            visited++;
+            m_links.augment(*path[--depth]);
+        }
+        return visited;
+    }
+private:
+    Links m_links;
+};
+
+// the AVL balancing shared by Streak and AvlTree. Node needs m_left, m_right and an int m_height (-1 stands for an
+// empty subtree), and Augment::update(node) recomputes whatever a node keeps about its subtree from its children.
+// every function is static and the links hold no state, so everything is resolved at compile time and an empty update
+// costs nothing
+template <class Node, class Augment>
+class AvlBalance{
+public:
+    // the Links of AvlRotations for pointer nodes
+    typedef Node *Ref;
+    static Ref none(){
+        return nullptr;
+    }
+    Ref &left(Ref aNode) const{
+        return aNode->m_left;
+    }
+    Ref &right(Ref aNode) const{
+        return aNode->m_right;
+    }
+    void setHeight(Ref aNode, int height) const{
+        aNode->m_height = height;
+    }
+    void augment(Ref aNode) const{
+        Augment::update(aNode);
+    }
+
+    // the height of a subtree, -1 for an empty one
+    static int height(const Node *aNode){
+        return aNode == nullptr ? -1 : aNode->m_height;
+    }
+
+    // updates height of a node, one more than its taller child
+    static void updateHeight(Node *aNode){
+        if (aNode != nullptr){
+            int left = height(aNode->m_left);
+            int right = height(aNode->m_right);
+            aNode->m_height = (left > right ? left : right) + 1;
+        }
+    }
+
+    static int checkImbalance(const Node *aNode){
+        return Rotations().checkImbalance(const_cast<Node*>(aNode));
+    }
+    static void update(Node *aNode){
+        Rotations().update(aNode);
+    }
+    static Node *rebalance(Node *aNode){
+        return Rotations().rebalance(aNode);
+    }
+    static Node *singleLeft(Node *aNode){
+        return Rotations().singleLeft(aNode);
+    }
+    static Node *singleRight(Node *aNode){
+        return Rotations().singleRight(aNode);
+    }
+    static Node *leftRight(Node *aNode){
+        return Rotations().leftRight(aNode);
+    }
+    static Node *rightLeft(Node *aNode){
+        return Rotations().rightLeft(aNode);
+    }
+    static int retrace(Node **path[], int depth){
+        return Rotations().retrace(path, depth);
+    }
+private:
+    typedef AvlRotations<AvlBalance> Rotations;
+};
+
+// augmentation that keeps nothing, the update is empty and compiles away
+struct NoAugment{
+    struct Data{};
+    template <class Node>
+    static void update(Node *){}
+};
+
+// augmentation that keeps the # of nodes of every subtree, for rank and select style queries
+struct SizeAugment{
+    struct Data{
+        int m_size = 1;
+    };
+    template <class Node>
+    static void update(Node *aNode){
+        aNode->m_size = 1 + (aNode->m_left == nullptr ? 0 : aNode->m_left->m_size)
+                          + (aNode->m_right == nullptr ? 0 : aNode->m_right->m_size);
+    }
+};
+
+// a node of AvlTree. the augmentation data is a base class, so an empty one takes no room
+template <class Key, class Value, class Augment>
+struct AvlNode : Augment::Data{
+    AvlNode(const Key &key, const Value &value) : m_key(key), m_value(value){}
+    Key m_key;
+    Value m_value;
+    AvlNode *m_left = nullptr;
+    AvlNode *m_right = nullptr;
+    int m_height = 0;
+};
+
+// an AVL map from Key to Value ordered by Compare. Augment keeps extra data about every subtree up to date through
+// every insert, remove and rotation, and Allocator (rebound to the node type) provides the nodes. the same one-pass
+// descents as Streak, with the same balancing
+template <class Key, class Value, class Compare = less<Key>, class Augment = NoAugment,
+          class Allocator = allocator<Key>>
+class AvlTree{
+public:
+    typedef AvlNode<Key, Value, Augment> Node;
+    typedef AvlBalance<Node, Augment> Balance;
+
+    AvlTree() : m_root(nullptr), m_size(0){}
+    explicit AvlTree(const Compare &compare, const Allocator &allocator = Allocator())
+        : m_root(nullptr), m_size(0), m_compare(compare), m_allocator(allocator){}
+    AvlTree(const AvlTree&) = delete;
+    AvlTree &operator=(const AvlTree&) = delete;
+    ~AvlTree(){
+        clear();
+    }
+
+    // inserts in one descent, returns false and leaves the tree as it is if the key is already there
+    bool insert(const Key &key, const Value &value){
+        Node **path[MAXDEPTH];
+        int depth = 0;
+        Node **link = &m_root;
+        while (*link != nullptr){
+            if (m_compare(key, (*link)->m_key)){
+                path[depth++] = link;
+                link = &(*link)->m_left;
+            }else if (m_compare((*link)->m_key, key)){
+                path[depth++] = link;
+                link = &(*link)->m_right;
+            }else{
+                return false;
+            }
+        }
+        Node *aNode = NodeTraits::allocate(m_allocator, 1);
+        NodeTraits::construct(m_allocator, aNode, key, value);
+        *link = aNode;
+        m_size++;
+        Balance::retrace(path, depth);
+        return true;
+    }
+
+    // removes in one descent, a node with two children is replaced by its in-order successor. returns false if the
+    // key is not in the tree
+    bool remove(const Key &key){
+        Node **path[MAXDEPTH];
+        int depth = 0;
+        Node **link = &m_root;
+        while (*link != nullptr){
+            if (m_compare(key, (*link)->m_key)){
+                path[depth++] = link;
+                link = &(*link)->m_left;
+            }else if (m_compare((*link)->m_key, key)){
+                path[depth++] = link;
+                link = &(*link)->m_right;
+            }else{
+                break;
+            }
+        }
+        Node *toDelete = *link;
+        if (toDelete == nullptr){
+            return false;
+        }
+        if (toDelete->m_left == nullptr){
+            *link = toDelete->m_right;
+        }else if (toDelete->m_right == nullptr){
+            *link = toDelete->m_left;
+        }else{
+            // the successor takes the removed node's place on the path, its old link is fixed once it is known
+            int top = depth;
+            path[depth++] = link;
+            Node **successor = &toDelete->m_right;
+            while ((*successor)->m_left != nullptr){
+                path[depth++] = successor;
+                successor = &(*successor)->m_left;
+            }
+            Node *replacement = *successor;
+            *successor = replacement->m_right;
+            replacement->m_left = toDelete->m_left;
+            replacement->m_right = toDelete->m_right;
+            replacement->m_height = toDelete->m_height;
+            *link = replacement;
+            if (depth > top + 1){
+                path[top + 1] = &replacement->m_right;
+            }
+        }
+        NodeTraits::destroy(m_allocator, toDelete);
+        NodeTraits::deallocate(m_allocator, toDelete, 1);
+        m_size--;
+        Balance::retrace(path, depth);
+        return true;
+    }
+
+    // returns the value of the key, nullptr if it is not in the tree
+    Value *find(const Key &key){
+        return const_cast<Value*>(static_cast<const AvlTree*>(this)->find(key));
+    }
+    // a descent that branches on the key being found, which is taken once. both compares are made before it, so the
+    // pick of the child does not depend on a branch and gcc makes it a conditional move
+    const Value *find(const Key &key) const{
+        const Node *aNode = m_root;
+        while (aNode != nullptr){
+            bool left = m_compare(key, aNode->m_key);
+            bool right = m_compare(aNode->m_key, key);
+            if (!left && !right){
+                return &aNode->m_value;
+            }
+            aNode = left ? aNode->m_left : aNode->m_right;
+        }
+        return nullptr;
+    }
+
+    // calls visitor(const Key&, const Value&) on every key with lo <= key <= hi in order
+    template <class Visitor>
+    void forEachInRange(const Key &lo, const Key &hi, Visitor &&visitor) const{
+        forEachInRange(lo, hi, visitor, m_root);
+    }
+
+    void clear(){
+        clear(m_root);
+        m_root = nullptr;
+        m_size = 0;
+    }
+    int size() const{
+        return m_size;
+    }
+    // the root, for queries on the augmentation. nullptr if the tree is empty
+    const Node *root() const{
+        return m_root;
+    }
+private:
+    typedef typename allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+    typedef allocator_traits<NodeAllocator> NodeTraits;
+
+    Node *m_root;
+    int m_size;
+    Compare m_compare;
+    NodeAllocator m_allocator;
+
+    void clear(Node *aNode){
+        if (aNode != nullptr){
+            clear(aNode->m_left);
+            clear(aNode->m_right);
+            NodeTraits::destroy(m_allocator, aNode);
+            NodeTraits::deallocate(m_allocator, aNode, 1);
+        }
+    }
+
+    // recurses to the left and loops to the right, like Streak::forEachInRange
+    template <class Visitor>
+    void forEachInRange(const Key &lo, const Key &hi, Visitor &visitor, const Node *aNode) const{
+        while (aNode != nullptr){
+            if (m_compare(aNode->m_key, lo)){
+                aNode = aNode->m_right;
+            }else if (m_compare(hi, aNode->m_key)){
+                aNode = aNode->m_left;
+            }else{
+                forEachInRange(lo, hi, visitor, aNode->m_left);
+                visitor(aNode->m_key, aNode->m_value);
+                aNode = aNode->m_right;
+            }
+        }
+    }
+};
+#endif
@@ -0,0 +1,468 @@
+#include "btreestreak.h"
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// constructor, starts with an empty tree
+BTreeStreak::BTreeStreak(){
+    m_root = nullptr;
+    clear();
+}
+
+// destructor, calls clear()
+BTreeStreak::~BTreeStreak(){
+    clear();
+}
+
+// checks if id is within MINID and MAXID, then walks down once. a full node on the way is split before it is entered,
+// so the leaf at the bottom always has room. a duplicate is found in the same descent, the nodes split before it was
+// found stay split, which leaves a valid tree
+RESULT BTreeStreak::insert(const Tiger& tiger){
+    int id = tiger.getID();
+    if (id < MINID || id > MAXID){
+        return OUTOFRANGE;
+    }
+    if (m_root == nullptr){
+        m_root = newNode(true);
+    }else if (m_root->m_count == BTREEKEYS - 1){
+        BTreeNode *root = newNode(false);
+        root->m_children[0] = m_root;
+        m_root = root;
+        splitChild(root, 0);
+    }
+    BTreeNode *node = m_root;
+    int pos = rank(node, id);
+    while (node->m_ids[pos] != id && !node->m_leaf){
+        if (node->m_children[pos]->m_count == BTREEKEYS - 1){
+            splitChild(node, pos);
+            // the median of the child moved up into slot pos
+            if (id == node->m_ids[pos]){
+                return DUPLICATE;
+            }
+            if (id > node->m_ids[pos]){
+                pos++;
+            }
+        }
+        node = node->m_children[pos];
+        pos = rank(node, id);
+    }
+    if (node->m_ids[pos] == id){
+        return DUPLICATE;
+    }
+    for (int i = node->m_count; i > pos; i--){
+        node->m_ids[i] = node->m_ids[i - 1];
+        node->m_attrs[i] = node->m_attrs[i - 1];
+    }
+    node->m_ids[pos] = id;
+    node->m_attrs[pos] = packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState());
+    node->m_count++;
+    count(node->m_attrs[pos], 1);
+    return INSERTED;
+}
+
+// deletes every node and resets the counts
+void BTreeStreak::clear(){
+    clear(m_root);
+    m_root = nullptr;
+    for (int i = 0; i < 3; i++){
+        m_ages[i] = 0;
+        m_genders[i] = 0;
+    }
+    m_states[ALIVE] = 0;
+    m_states[DEAD] = 0;
+}
+
+// removes a tiger if it exists in the tree, in one pass down. a root left without tigers gives its place to its only
+// child
+bool BTreeStreak::remove(int id){
+    uint8_t *attrs = find(id);
+    if (attrs == nullptr){
+        return false;
+    }
+    count(*attrs, -1);
+    remove(m_root, id);
+    if (m_root->m_count == 0){
+        BTreeNode *root = m_root;
+        m_root = root->m_leaf ? nullptr : root->m_children[0];
+        delete root;
+    }
+    return true;
+}
+
+void BTreeStreak::dumpTree() const {dump(m_root);}
+
+void BTreeStreak::listTigers() const{
+    forEachInRange(MINID, MAXID, [](const Tiger &tiger){
+        cout << tiger.getID() << ":" << tiger.getAgeStr() << ":" << tiger.getGenderStr() << ":" << tiger.getStateStr()
+        << endl;
+    });
+}
+
+// sets state of specific tiger; checks if it exists
+bool BTreeStreak::setState(int id, STATE state){
+    uint8_t *attrs = find(id);
+    if (attrs == nullptr){
+        return false;
+    }
+    count(*attrs, -1);
+    *attrs = packAttrs(unpackAge(*attrs), unpackGender(*attrs), state);
+    count(*attrs, 1);
+    return true;
+}
+
+// removes all dead tigers in O(n): one in order pass keeps the alive tigers and deletes every node, then the alive
+// tigers are built into a new tree with full nodes
+int BTreeStreak::removeDead(){
+    vector<uint32_t> alive;
+    alive.reserve(size());
+    int removed = 0;
+    collectAlive(m_root, alive, removed);
+    m_root = nullptr;
+    if (!alive.empty()){
+        int height = 0;
+        for (long long capacity = BTREEKEYS - 1; capacity < (long long)alive.size(); height++){
+            capacity = (capacity + 1) * BTREEKEYS - 1;
+        }
+        m_root = build(alive, 0, alive.size(), height);
+    }
+    return removed;
+}
+
+// returns true if tiger is in tree. returns false if it isn't
+bool BTreeStreak::findTiger(int id) const{
+    return find(id) != nullptr;
+}
+
+bool BTreeStreak::getTiger(int id, Tiger &tiger) const{
+    uint8_t *attrs = find(id);
+    if (attrs == nullptr){
+        return false;
+    }
+    tiger = Tiger(id, unpackAge(*attrs), unpackGender(*attrs), unpackState(*attrs));
+    return true;
+}
+
+int BTreeStreak::countTigerCubs() const{
+    return m_ages[CUB];
+}
+
+int BTreeStreak::countBy(AGE age) const{
+    return m_ages[age];
+}
+
+int BTreeStreak::countBy(GENDER gender) const{
+    return m_genders[gender];
+}
+
+int BTreeStreak::countBy(STATE state) const{
+    return m_states[state];
+}
+
+int BTreeStreak::size() const{
+    return m_ages[CUB] + m_ages[YOUNG] + m_ages[OLD];
+}
+
+// returns the # of ids in the node smaller than id, which is the slot of id or the child to descend into. every slot
+// is compared, the padding never counts since nothing is larger than INT_MAX
+int BTreeStreak::rank(const BTreeNode *node, int id){
+#if defined(__AVX2__)
+    // every compare gives -1 in the lanes with a smaller id, the lanes are summed and negated at the end
+    __m256i key = _mm256_set1_epi32(id);
+    __m256i smaller = _mm256_setzero_si256();
+    for (int i = 0; i < BTREEKEYS; i += 8){
+        __m256i ids = _mm256_load_si256(reinterpret_cast<const __m256i*>(node->m_ids + i));
+        smaller = _mm256_add_epi32(smaller, _mm256_cmpgt_epi32(key, ids));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(smaller), _mm256_extracti128_si256(smaller, 1));
+#elif defined(__SSE2__)
+    __m128i key = _mm_set1_epi32(id);
+    __m128i half = _mm_setzero_si128();
+    for (int i = 0; i < BTREEKEYS; i += 4){
+        __m128i ids = _mm_load_si128(reinterpret_cast<const __m128i*>(node->m_ids + i));
+        half = _mm_add_epi32(half, _mm_cmpgt_epi32(key, ids));
+    }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return -_mm_cvtsi128_si32(half);
+#else
+    int smaller = 0;
+    for (int i = 0; i < BTREEKEYS; i++){
+        smaller += node->m_ids[i] < id;
+    }
+    return smaller;
+#endif
+}
+
+BTreeNode *BTreeStreak::newNode(bool leaf){
+    BTreeNode *node = new BTreeNode;
+    node->m_count = 0;
+    node->m_leaf = leaf;
+    pad(node);
+    return node;
+}
+
+// fills the id slots past the last tiger with INT_MAX
+void BTreeStreak::pad(BTreeNode *node){
+    for (int i = node->m_count; i < BTREEKEYS; i++){
+        node->m_ids[i] = INT_MAX;
+    }
+}
+
+// recursively deletes nodes by post order traversal
+void BTreeStreak::clear(BTreeNode *node){
+    if (node != nullptr){
+        if (!node->m_leaf){
+            for (int i = 0; i <= node->m_count; i++){
+                clear(node->m_children[i]);
+            }
+        }
+        delete node;
+    }
+}
+
+// adds delta to the count of the age, gender and state in attrs
+void BTreeStreak::count(uint8_t attrs, int delta){
+    m_ages[unpackAge(attrs)] += delta;
+    m_genders[unpackGender(attrs)] += delta;
+    m_states[unpackState(attrs)] += delta;
+}
+
+// returns the attribute byte of the tiger with this id, nullptr if it is not in the tree
+uint8_t *BTreeStreak::find(int id) const{
+    BTreeNode *node = m_root;
+    while (node != nullptr){
+        int pos = rank(node, id);
+        if (node->m_ids[pos] == id){
+            return &node->m_attrs[pos];
+        }
+        node = node->m_leaf ? nullptr : node->m_children[pos];
+    }
+    return nullptr;
+}
+
+// splits the full child at pos around its middle tiger, which moves up into node. both halves keep BTREEMIN tigers
+void BTreeStreak::splitChild(BTreeNode *node, int pos){
+    BTreeNode *child = node->m_children[pos];
+    BTreeNode *sibling = newNode(child->m_leaf);
+    int middle = BTREEMIN;
+    sibling->m_count = child->m_count - middle - 1;
+    for (int i = 0; i < sibling->m_count; i++){
+        sibling->m_ids[i] = child->m_ids[middle + 1 + i];
+        sibling->m_attrs[i] = child->m_attrs[middle + 1 + i];
+    }
+    if (!child->m_leaf){
+        for (int i = 0; i <= sibling->m_count; i++){
+            sibling->m_children[i] = child->m_children[middle + 1 + i];
+        }
+    }
+    for (int i = node->m_count; i > pos; i--){
+        node->m_ids[i] = node->m_ids[i - 1];
+        node->m_attrs[i] = node->m_attrs[i - 1];
+        node->m_children[i + 1] = node->m_children[i];
+    }
+    node->m_ids[pos] = child->m_ids[middle];
+    node->m_attrs[pos] = child->m_attrs[middle];
+    node->m_children[pos + 1] = sibling;
+    node->m_count++;
+    child->m_count = middle;
+    pad(child);
+}
+
+// merges the child at pos + 1 and the tiger between them into the child at pos, and deletes the emptied child
+void BTreeStreak::mergeChildren(BTreeNode *node, int pos){
+    BTreeNode *left = node->m_children[pos];
+    BTreeNode *right = node->m_children[pos + 1];
+    left->m_ids[left->m_count] = node->m_ids[pos];
+    left->m_attrs[left->m_count] = node->m_attrs[pos];
+    for (int i = 0; i < right->m_count; i++){
+        left->m_ids[left->m_count + 1 + i] = right->m_ids[i];
+        left->m_attrs[left->m_count + 1 + i] = right->m_attrs[i];
+    }
+    if (!left->m_leaf){
+        for (int i = 0; i <= right->m_count; i++){
+            left->m_children[left->m_count + 1 + i] = right->m_children[i];
+        }
+    }
+    left->m_count += right->m_count + 1;
+    for (int i = pos; i < node->m_count - 1; i++){
+        node->m_ids[i] = node->m_ids[i + 1];
+        node->m_attrs[i] = node->m_attrs[i + 1];
+        node->m_children[i + 1] = node->m_children[i + 2];
+    }
+    node->m_count--;
+    pad(node);
+    delete right;
+}
+
+// gives the child at pos, which holds only BTREEMIN tigers, one more: rotated in through node from a sibling that can
+// spare one, otherwise by merging with a sibling
+void BTreeStreak::fillChild(BTreeNode *node, int pos){
+    BTreeNode *child = node->m_children[pos];
+    if (pos > 0 && node->m_children[pos - 1]->m_count > BTREEMIN){
+        BTreeNode *left = node->m_children[pos - 1];
+        for (int i = child->m_count; i > 0; i--){
+            child->m_ids[i] = child->m_ids[i - 1];
+            child->m_attrs[i] = child->m_attrs[i - 1];
+        }
+        if (!child->m_leaf){
+            for (int i = child->m_count + 1; i > 0; i--){
+                child->m_children[i] = child->m_children[i - 1];
+            }
+            child->m_children[0] = left->m_children[left->m_count];
+        }
+        child->m_ids[0] = node->m_ids[pos - 1];
+        child->m_attrs[0] = node->m_attrs[pos - 1];
+        child->m_count++;
+        left->m_count--;
+        node->m_ids[pos - 1] = left->m_ids[left->m_count];
+        node->m_attrs[pos - 1] = left->m_attrs[left->m_count];
+        pad(left);
+    }else if (pos < node->m_count && node->m_children[pos + 1]->m_count > BTREEMIN){
+        BTreeNode *right = node->m_children[pos + 1];
+        child->m_ids[child->m_count] = node->m_ids[pos];
+        child->m_attrs[child->m_count] = node->m_attrs[pos];
+        if (!child->m_leaf){
+            child->m_children[child->m_count + 1] = right->m_children[0];
+        }
+        child->m_count++;
+        node->m_ids[pos] = right->m_ids[0];
+        node->m_attrs[pos] = right->m_attrs[0];
+        for (int i = 0; i < right->m_count - 1; i++){
+            right->m_ids[i] = right->m_ids[i + 1];
+            right->m_attrs[i] = right->m_attrs[i + 1];
+        }
+        if (!right->m_leaf){
+            for (int i = 0; i < right->m_count; i++){
+                right->m_children[i] = right->m_children[i + 1];
+            }
+        }
+        right->m_count--;
+        pad(right);
+    }else if (pos < node->m_count){
+        mergeChildren(node, pos);
+    }else{
+        mergeChildren(node, pos - 1);
+    }
+}
+
+// removes id, which is in the subtree, making sure every child entered has a tiger to spare. a tiger in an inner
+// node is replaced by its predecessor or successor, which is then removed from the child that holds it
+void BTreeStreak::remove(BTreeNode *node, int id){
+    int pos = rank(node, id);
+    if (pos < node->m_count && node->m_ids[pos] == id){
+        if (node->m_leaf){
+            for (int i = pos; i < node->m_count - 1; i++){
+                node->m_ids[i] = node->m_ids[i + 1];
+                node->m_attrs[i] = node->m_attrs[i + 1];
+            }
+            node->m_count--;
+            pad(node);
+            return;
+        }
+        if (node->m_children[pos]->m_count > BTREEMIN){
+            BTreeNode *predecessor = node->m_children[pos];
+            while (!predecessor->m_leaf){
+                predecessor = predecessor->m_children[predecessor->m_count];
+            }
+            node->m_ids[pos] = predecessor->m_ids[predecessor->m_count - 1];
+            node->m_attrs[pos] = predecessor->m_attrs[predecessor->m_count - 1];
+            remove(node->m_children[pos], node->m_ids[pos]);
+        }else if (node->m_children[pos + 1]->m_count > BTREEMIN){
+            BTreeNode *successor = node->m_children[pos + 1];
+            while (!successor->m_leaf){
+                successor = successor->m_children[0];
+            }
+            node->m_ids[pos] = successor->m_ids[0];
+            node->m_attrs[pos] = successor->m_attrs[0];
+            remove(node->m_children[pos + 1], node->m_ids[pos]);
+        }else{
+            mergeChildren(node, pos);
+            remove(node->m_children[pos], id);
+        }
+        return;
+    }
+    if (node->m_children[pos]->m_count == BTREEMIN){
+        fillChild(node, pos);
+        // a merge with the left sibling moved the tigers one child to the left
+        if (pos > node->m_count){
+            pos--;
+        }
+    }
+    remove(node->m_children[pos], id);
+}
+
+// builds tigers[lo, hi), sorted packed tigers, into a subtree with every leaf height levels down. the range is spread
+// evenly over as few children as can hold it, which leaves each of them at least half full
+BTreeNode *BTreeStreak::build(const vector<uint32_t> &tigers, int lo, int hi, int height){
+    int n = hi - lo;
+    BTreeNode *node = newNode(height == 0);
+    if (height == 0){
+        for (int i = 0; i < n; i++){
+            node->m_ids[i] = (tigers[lo + i] >> 8) + MINID;
+            node->m_attrs[i] = tigers[lo + i] & 0xff;
+        }
+        node->m_count = n;
+        return node;
+    }
+    long long childCapacity = BTREEKEYS - 1;
+    for (int level = 1; level < height; level++){
+        childCapacity = (childCapacity + 1) * BTREEKEYS - 1;
+    }
+    int children = (n + 1 + childCapacity) / (childCapacity + 1);
+    int start = lo;
+    for (int i = 0; i < children; i++){
+        int end = lo + (long long)(n + 1) * (i + 1) / children - 1;
+        node->m_children[i] = build(tigers, start, end, height - 1);
+        if (i < children - 1){
+            node->m_ids[i] = (tigers[end] >> 8) + MINID;
+            node->m_attrs[i] = tigers[end] & 0xff;
+        }
+        start = end + 1;
+    }
+    node->m_count = children - 1;
+    return node;
+}
+
+// in order traversal that appends the alive tigers packed like Streak does, uncounts the dead ones and deletes every
+// node
+void BTreeStreak::collectAlive(BTreeNode *node, vector<uint32_t> &alive, int &removed){
+    if (node == nullptr){
+        return;
+    }
+    for (int i = 0; i <= node->m_count; i++){
+        if (!node->m_leaf){
+            collectAlive(node->m_children[i], alive, removed);
+        }
+        if (i < node->m_count){
+            uint8_t attrs = node->m_attrs[i];
+            if (unpackState(attrs) == DEAD){
+                count(attrs, -1);
+                removed++;
+            }else{
+                alive.push_back((uint32_t)(node->m_ids[i] - MINID) << 8 | attrs);
+            }
+        }
+    }
+    delete node;
+}
+
+void BTreeStreak::dump(const BTreeNode *node) const{
+    if (node != nullptr){
+        cout << "(";
+        for (int i = 0; i <= node->m_count; i++){
+            if (node->m_leaf){
+                if (i < node->m_count){
+                    cout << (i > 0 ? " " : "") << node->m_ids[i];
+                }
+            }else{
+                dump(node->m_children[i]);//first visit the child left of the tiger
+                if (i < node->m_count){
+                    cout << " " << node->m_ids[i] << " ";//then the tiger itself
+                }
+            }
+        }
+        cout << ")";
+    }
+}
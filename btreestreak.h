@@ -0,0 +1,97 @@
+#ifndef BTREESTREAK_H
+#define BTREESTREAK_H
+#include "streak.h"
+#include <cstdint>
+#include <climits>
+#include <vector>
+
+// a B-tree node holds up to BTREEKEYS - 1 tigers. the id slots past the last tiger hold INT_MAX, so a search can
+// compare all BTREEKEYS slots at once without looking at the count
+const int BTREEKEYS = 32;
+const int BTREEMIN = BTREEKEYS / 2 - 1;//the fewest tigers a node other than the root holds
+
+struct BTreeNode{
+    alignas(32) int32_t m_ids[BTREEKEYS];//sorted ids, INT_MAX from m_count on
+    uint8_t m_attrs[BTREEKEYS];//age | gender << 2 | state << 4 of the tiger in the same slot
+    int m_count;//number of tigers in the node
+    bool m_leaf;
+    BTreeNode *m_children[BTREEKEYS];//m_children[i] holds the ids between m_ids[i - 1] and m_ids[i]
+};
+
+// the Streak API on a B-tree with up to 31 tigers per node instead of one, so a lookup fetches a few wide nodes
+// instead of a cache line per level. the search inside a node compares every slot with AVX2 or SSE2 when the compiler
+// targets them, and with a scalar loop otherwise. whole streak counts are kept in the container, like CompactStreak
+class BTreeStreak{
+public:
+    friend class Tester;
+    BTreeStreak();
+    ~BTreeStreak();
+    RESULT insert(const Tiger& tiger);
+    void clear();
+    bool remove(int id);// returns false if the id is not in the tree
+    void dumpTree() const;// every node as (child id child id ... child)
+    void listTigers() const;
+    bool setState(int id, STATE state);
+    int removeDead();//remove all dead tigers from the tree, returns how many were removed
+    bool findTiger(int id) const;//returns true if the tiger is in tree
+    bool getTiger(int id, Tiger &tiger) const;//copies the tiger with this id into tiger, returns false if there is none
+    int countTigerCubs() const;// returns the # of cubs in the streak
+    int countBy(AGE age) const;
+    int countBy(GENDER gender) const;
+    int countBy(STATE state) const;
+    int size() const;
+    // calls visitor(const Tiger&) on every tiger with lo <= id <= hi in increasing id order
+    template <class Visitor>
+    void forEachInRange(int lo, int hi, Visitor &&visitor) const{
+        forEachInRange(lo, hi, visitor, m_root);
+    }
+private:
+    BTreeNode *m_root;//nullptr if the tree is empty
+    int m_ages[3];//number of tigers of each AGE
+    int m_genders[3];//number of tigers of each GENDER
+    int m_states[2];//number of tigers of each STATE
+
+    static int rank(const BTreeNode *node, int id);
+    static BTreeNode *newNode(bool leaf);
+    static void pad(BTreeNode *node);
+    void clear(BTreeNode *node);
+    void count(uint8_t attrs, int delta);
+    uint8_t *find(int id) const;
+    void splitChild(BTreeNode *node, int pos);
+    void mergeChildren(BTreeNode *node, int pos);
+    void fillChild(BTreeNode *node, int pos);
+    void remove(BTreeNode *node, int id);
+    BTreeNode *build(const vector<uint32_t> &tigers, int lo, int hi, int height);
+    void collectAlive(BTreeNode *node, vector<uint32_t> &alive, int &removed);
+    void dump(const BTreeNode *node) const;
+    template <class Visitor>
+    void forEachInRange(int lo, int hi, Visitor &visitor, const BTreeNode *node) const;
+};
+
+// visits the child left of every tiger in range and the one right of the last, starting at the first slot that can
+// hold lo
+template <class Visitor>
+void BTreeStreak::forEachInRange(int lo, int hi, Visitor &visitor, const BTreeNode *node) const{
+    if (node == nullptr){
+        return;
+    }
+    for (int i = rank(node, lo); ; i++){
+        if (!node->m_leaf){
+            forEachInRange(lo, hi, visitor, node->m_children[i]);
+        }
+        if (i == node->m_count || node->m_ids[i] > hi){
+            return;
+        }
+        uint8_t attrs = node->m_attrs[i];
+        visitor(static_cast<const Tiger&>(Tiger(node->m_ids[i], unpackAge(attrs), unpackGender(attrs),
+                                                unpackState(attrs))));
+    }
+}
+
+// STREAK_BTREE picks the backend of code written against StreakBackend at compile time
+#ifdef STREAK_BTREE
+typedef BTreeStreak StreakBackend;
+#else
+typedef Streak StreakBackend;
+#endif
+#endif
@@ -0,0 +1,268 @@
+#include "compactstreak.h"
+
+// constructor, starts with only the sentinel in the pool
+CompactStreak::CompactStreak(){
+    clear();
+}
+
+// checks if id is within MINID and MAXID, then walks down once recording the link to every node on the way, like
+// Streak::insert. the links point into the pool, so room for the new node is made before the descent, or appending it
+// could move the pool under them
+RESULT CompactStreak::insert(const Tiger& tiger){
+    if (tiger.getID() < MINID || tiger.getID() > MAXID){
+        return OUTOFRANGE;
+    }
+    if (m_free == NIL && m_nodes.size() == m_nodes.capacity()){
+        m_nodes.reserve(2 * m_nodes.size());
+    }
+    uint32_t key = tiger.getID() - MINID;
+    uint32_t *path[MAXDEPTH];
+    int depth = 0;
+    uint32_t *link = &m_root;
+    while (*link != NIL){
+        CompactTiger &node = m_nodes[*link];
+        // if the id is already in the tree, nothing is inserted
+        if (key == node.m_key){
+            return DUPLICATE;
+        }
+        path[depth++] = link;
+        link = key < node.m_key ? &node.m_left : &node.m_right;
+    }
+    *link = allocate(tiger);
+    balance().retrace(path, depth);
+    return INSERTED;
+}
+
+// empties the pool down to the sentinel
+void CompactStreak::clear(){
+    m_nodes.assign(1, CompactTiger());
+    m_root = NIL;
+    m_free = NIL;
+    for (int i = 0; i < 3; i++){
+        m_ages[i] = 0;
+        m_genders[i] = 0;
+    }
+    m_states[ALIVE] = 0;
+    m_states[DEAD] = 0;
+}
+
+// removes a node if it exists in the tree, in one pass. a node with two children is replaced by its in-order
+// successor, which is spliced out of the right subtree during the same descent, like Streak::remove
+bool CompactStreak::remove(int id){
+    if (id < MINID || id > MAXID){
+        return false;
+    }
+    uint32_t key = id - MINID;
+    uint32_t *path[MAXDEPTH];
+    int depth = 0;
+    uint32_t *link = &m_root;
+    while (*link != NIL && m_nodes[*link].m_key != key){
+        path[depth++] = link;
+        link = key < m_nodes[*link].m_key ? &m_nodes[*link].m_left : &m_nodes[*link].m_right;
+    }
+    uint32_t aTiger = *link;
+    if (aTiger == NIL){
+        return false;
+    }
+    CompactTiger &toDelete = m_nodes[aTiger];
+    // zero or one child, the child (or NIL) takes the node's place
+    if (toDelete.m_left == NIL){
+        *link = toDelete.m_right;
+    }else if (toDelete.m_right == NIL){
+        *link = toDelete.m_left;
+    }else{
+        // two children, keep descending to the leftmost node of the right subtree
+        int top = depth;
+        path[depth++] = link;
+        uint32_t *successorLink = &toDelete.m_right;
+        while (m_nodes[*successorLink].m_left != NIL){
+            path[depth++] = successorLink;
+            successorLink = &m_nodes[*successorLink].m_left;
+        }
+        uint32_t successor = *successorLink;
+        *successorLink = m_nodes[successor].m_right;
+        m_nodes[successor].m_left = toDelete.m_left;
+        m_nodes[successor].m_right = toDelete.m_right;
+        m_nodes[successor].m_height = toDelete.m_height;
+        *link = successor;
+        // the path entry below the removed node pointed into it, it has to point into the successor now
+        if (depth > top + 1){
+            path[top + 1] = &m_nodes[successor].m_right;
+        }
+    }
+    deallocate(aTiger);
+    balance().retrace(path, depth);
+    return true;
+}
+
+void CompactStreak::dumpTree() const {dump(m_root);}
+
+void CompactStreak::listTigers() const {
+    listTigers(m_root);
+}
+
+// sets state of specific tiger; checks if it exists
+bool CompactStreak::setState(int id, STATE state){
+    uint32_t aTiger = find(id);
+    if (aTiger == NIL){
+        return false;
+    }
+    CompactTiger &node = m_nodes[aTiger];
+    count(node.m_attrs, -1);
+    node.m_attrs = packAttrs(unpackAge(node.m_attrs), unpackGender(node.m_attrs), state);
+    count(node.m_attrs, 1);
+    return true;
+}
+
+// removes all dead tigers in O(n): one in order pass keeps the indices of the alive tigers and frees the dead ones,
+// then the alive nodes are rebuilt into a perfectly balanced tree
+int CompactStreak::removeDead(){
+    vector<uint32_t> alive;
+    alive.reserve(size());
+    int removed = 0;
+    collectAlive(m_root, alive, removed);
+    m_root = buildBalanced(alive, 0, (int)alive.size() - 1);
+    return removed;
+}
+
+// returns true if tiger is in tree. returns false if it isn't
+bool CompactStreak::findTiger(int id) const {
+    return find(id) != NIL;
+}
+
+bool CompactStreak::getTiger(int id, Tiger &tiger) const {
+    uint32_t aTiger = find(id);
+    if (aTiger == NIL){
+        return false;
+    }
+    uint8_t attrs = m_nodes[aTiger].m_attrs;
+    tiger = Tiger(id, unpackAge(attrs), unpackGender(attrs), unpackState(attrs));
+    return true;
+}
+
+int CompactStreak::countTigerCubs() const{
+    return m_ages[CUB];
+}
+
+int CompactStreak::countBy(AGE age) const{
+    return m_ages[age];
+}
+
+int CompactStreak::countBy(GENDER gender) const{
+    return m_genders[gender];
+}
+
+int CompactStreak::countBy(STATE state) const{
+    return m_states[state];
+}
+
+int CompactStreak::size() const{
+    return m_ages[CUB] + m_ages[YOUNG] + m_ages[OLD];
+}
+
+// reuses a freed node if there is one, otherwise appends to the pool. the new node is a leaf
+uint32_t CompactStreak::allocate(const Tiger& tiger){
+    uint32_t aTiger;
+    if (m_free != NIL){
+        aTiger = m_free;
+        m_free = m_nodes[aTiger].m_left;
+    }else{
+        aTiger = m_nodes.size();
+        m_nodes.push_back(CompactTiger());
+    }
+    CompactTiger &node = m_nodes[aTiger];
+    node.m_left = NIL;
+    node.m_right = NIL;
+    node.m_key = tiger.getID() - MINID;
+    node.m_height = DEFAULT_HEIGHT;
+    node.m_attrs = packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState());
+    count(node.m_attrs, 1);
+    return aTiger;
+}
+
+// uncounts the node and puts it on the free list
+void CompactStreak::deallocate(uint32_t aTiger){
+    count(m_nodes[aTiger].m_attrs, -1);
+    m_nodes[aTiger].m_left = m_free;
+    m_free = aTiger;
+}
+
+// adds delta to the count of the age, gender and state in attrs
+void CompactStreak::count(uint8_t attrs, int delta){
+    m_ages[unpackAge(attrs)] += delta;
+    m_genders[unpackGender(attrs)] += delta;
+    m_states[unpackState(attrs)] += delta;
+}
+
+AvlRotations<CompactLinks> CompactStreak::balance(){
+    return AvlRotations<CompactLinks>(CompactLinks{m_nodes.data()});
+}
+
+// returns the index of the tiger with this id, NIL if it is not in the tree
+uint32_t CompactStreak::find(int id) const{
+    if (id < MINID || id > MAXID){
+        return NIL;
+    }
+    uint32_t key = id - MINID;
+    const CompactTiger *nodes = m_nodes.data();
+    uint32_t aTiger = m_root;
+    while (aTiger != NIL){
+        const CompactTiger &node = nodes[aTiger];
+        uint32_t nodeKey = node.m_key;
+        if (nodeKey == key){
+            break;
+        }
+        aTiger = key < nodeKey ? node.m_left : node.m_right;
+    }
+    return aTiger;
+}
+
+// links tigers[lo..hi], in id order, into a perfectly balanced tree and returns its root
+uint32_t CompactStreak::buildBalanced(const vector<uint32_t> &tigers, int lo, int hi){
+    if (lo > hi){
+        return NIL;
+    }
+    int mid = lo + (hi - lo + 1) / 2;
+    uint32_t root = tigers[mid];
+    m_nodes[root].m_left = buildBalanced(tigers, lo, mid - 1);
+    m_nodes[root].m_right = buildBalanced(tigers, mid + 1, hi);
+    balance().update(root);
+    return root;
+}
+
+void CompactStreak::dump(uint32_t aTiger) const{
+    if (aTiger != NIL){
+        cout << "(";
+        dump(m_nodes[aTiger].m_left);//first visit the left child
+        cout << m_nodes[aTiger].m_key + MINID << ":" << m_nodes[aTiger].m_height;//second visit the node itself
+        dump(m_nodes[aTiger].m_right);//third visit the right child
+        cout << ")";
+    }
+}
+
+// lists tigers and their elements in the same format as Streak, in order traversal
+void CompactStreak::listTigers(uint32_t aTiger) const{
+    if (aTiger != NIL){
+        listTigers(m_nodes[aTiger].m_left);
+        uint8_t attrs = m_nodes[aTiger].m_attrs;
+        Tiger tiger(m_nodes[aTiger].m_key + MINID, unpackAge(attrs), unpackGender(attrs), unpackState(attrs));
+        cout << tiger.getID() << ":" << tiger.getAgeStr() << ":" << tiger.getGenderStr() << ":" << tiger.getStateStr()
+        << endl;
+        listTigers(m_nodes[aTiger].m_right);
+    }
+}
+
+// in order traversal that appends alive tigers to alive and frees the dead ones
+void CompactStreak::collectAlive(uint32_t aTiger, vector<uint32_t> &alive, int &removed){
+    if (aTiger != NIL){
+        uint32_t right = m_nodes[aTiger].m_right;
+        collectAlive(m_nodes[aTiger].m_left, alive, removed);
+        if (unpackState(m_nodes[aTiger].m_attrs) == DEAD){
+            deallocate(aTiger);
+            removed++;
+        }else{
+            alive.push_back(aTiger);
+        }
+        collectAlive(right, alive, removed);
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef COMPACTSTREAK_H
+#define COMPACTSTREAK_H
+#include "streak.h"
+#include <cstdint>
+#include <vector>
+
+// a tiger node packed into 12 bytes. the id is stored as an offset from MINID (17 bits cover MINID..MAXID), age,
+// gender and state share one byte, and the children are 32-bit indices into the pool of the CompactStreak that owns
+// the node instead of pointers
+struct CompactTiger{
+    uint32_t m_left;//index of the left child, NIL if there is none
+    uint32_t m_right;//index of the right child, NIL if there is none
+    uint32_t m_key : 17;//id - MINID
+    uint32_t m_height : 7;//the height of node in the BST
+    uint32_t m_attrs : 8;//age | gender << 2 | state << 4
+};
+static_assert(sizeof(CompactTiger) <= 16, "a compact node has to fit in 16 bytes");
+
+// index 0 of every pool is a sentinel that stands for nullptr
+const uint32_t NIL = 0;
+
+// the Links of AvlRotations for a pool of compact nodes, so CompactStreak balances with the same code as Streak. a node
+// is named by its index and the links are the index fields themselves
+struct CompactLinks{
+    typedef uint32_t Ref;
+    CompactTiger *m_nodes;
+    static Ref none(){
+        return NIL;
+    }
+    uint32_t &left(Ref aTiger) const{
+        return m_nodes[aTiger].m_left;
+    }
+    uint32_t &right(Ref aTiger) const{
+        return m_nodes[aTiger].m_right;
+    }
+    int height(Ref aTiger) const{
+        return aTiger == NIL ? -1 : m_nodes[aTiger].m_height;
+    }
+    void setHeight(Ref aTiger, int height) const{
+        m_nodes[aTiger].m_height = height;
+    }
+    void augment(Ref) const{}//the counts are kept in the container
+};
+
+// the Streak API on compact nodes. tigers go in and come out as Tiger objects, so the Tiger accessors behave exactly
+// as they do with Streak, but each node takes 12 bytes instead of a full Tiger. whole streak counts are kept in the
+// container instead of in every node. the smaller nodes save memory more than lookup time: a descent is a chain of
+// dependent loads either way, and every link here is an index the address has to be worked out from, so lookups only
+// gain once the Tigers of a streak would no longer fit in the cache
+class CompactStreak{
+public:
+    friend class Tester;
+    CompactStreak();
+    RESULT insert(const Tiger& tiger);
+    void clear();
+    bool remove(int id);// returns false if the id is not in the tree
+    void dumpTree() const;
+    void listTigers() const;
+    bool setState(int id, STATE state);
+    int removeDead();//remove all dead tigers from the tree, returns how many were removed
+    bool findTiger(int id) const;//returns true if the tiger is in tree
+    bool getTiger(int id, Tiger &tiger) const;//copies the tiger with this id into tiger, returns false if there is none
+    int countTigerCubs() const;// returns the # of cubs in the streak
+    int countBy(AGE age) const;
+    int countBy(GENDER gender) const;
+    int countBy(STATE state) const;
+    int size() const;
+private:
+    vector<CompactTiger> m_nodes;//the pool, m_nodes[NIL] is the sentinel
+    uint32_t m_root;//index of the root of the BST
+    uint32_t m_free;//nodes given back, linked through m_left
+    int m_ages[3];//number of tigers of each AGE
+    int m_genders[3];//number of tigers of each GENDER
+    int m_states[2];//number of tigers of each STATE
+
+    uint32_t allocate(const Tiger& tiger);
+    void deallocate(uint32_t aTiger);
+    void count(uint8_t attrs, int delta);
+    AvlRotations<CompactLinks> balance();// the balancing on the pool as it is now, a new node can move it
+    uint32_t find(int id) const;
+    uint32_t buildBalanced(const vector<uint32_t> &tigers, int lo, int hi);
+    void dump(uint32_t aTiger) const;
+    void listTigers(uint32_t aTiger) const;
+    void collectAlive(uint32_t aTiger, vector<uint32_t> &alive, int &removed);
+};
+#endif
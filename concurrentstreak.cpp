@@ -0,0 +1,472 @@
+#include "concurrentstreak.h"
+
+ConcurrentStreak::ConcurrentStreak(){
+    m_root.store(nullptr);
+    m_version = 1;
+}
+
+// no reader can be inside any more, so every node goes at once. the snapshots are gone too, they may not outlive the
+// streak
+ConcurrentStreak::~ConcurrentStreak(){
+    clear();
+    reclaim(true);
+}
+
+// checks if id is within MINID and MAXID, then walks down once. a duplicate is found on the way and nothing is copied,
+// otherwise the path is copied back up onto the new leaf
+RESULT ConcurrentStreak::insert(const Tiger& tiger){
+    if (tiger.getID() < MINID || tiger.getID() > MAXID){
+        return OUTOFRANGE;
+    }
+    lock_guard<mutex> lock(m_writer);
+    SharedTiger *root = m_root.load();
+    SharedTiger *path[MAXDEPTH];
+    int depth = descend(root, tiger.getID(), path);
+    if (depth > 0 && path[depth - 1]->m_id == tiger.getID()){
+        return DUPLICATE;
+    }
+    SharedTiger *leaf = newTiger(tiger.getID(), packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState()));
+    publish(copyPath(root, path, depth, tiger.getID(), leaf));
+    return INSERTED;
+}
+
+// publishes an empty tree and retires every node of the old one that no snapshot holds
+void ConcurrentStreak::clear(){
+    lock_guard<mutex> lock(m_writer);
+    release(m_root.load());
+    publish(nullptr);
+}
+
+// walks down once to the tiger, and puts its children in its place, or a new node with its in-order successor's tiger
+// if it has two. the removed node is not released on its own, it goes with the old path when the old root is released
+bool ConcurrentStreak::remove(int id){
+    lock_guard<mutex> lock(m_writer);
+    SharedTiger *root = m_root.load();
+    SharedTiger *path[MAXDEPTH];
+    int depth = descend(root, id, path);
+    if (depth == 0 || path[depth - 1]->m_id != id){
+        return false;
+    }
+    SharedTiger *aTiger = path[--depth];
+    SharedTiger *left = aTiger->m_left;
+    SharedTiger *right = aTiger->m_right;
+    hold(left);
+    hold(right);
+    SharedTiger *subtree = left == nullptr ? right : left;
+    if (left != nullptr && right != nullptr){
+        int successor;
+        uint8_t attrs;
+        right = removeMin(right, successor, attrs);
+        subtree = newTiger(successor, attrs);
+        subtree->m_left = left;
+        subtree->m_right = right;
+        subtree = rebalance(subtree);
+    }
+    publish(copyPath(root, path, depth, id, subtree));
+    return true;
+}
+
+// walks down once to the tiger and copies it with the new state, then the path above it. readers see the old state or
+// the new one. a tiger that has the state already is left as it is
+bool ConcurrentStreak::setState(int id, STATE state){
+    lock_guard<mutex> lock(m_writer);
+    SharedTiger *root = m_root.load();
+    SharedTiger *path[MAXDEPTH];
+    int depth = descend(root, id, path);
+    if (depth == 0 || path[depth - 1]->m_id != id){
+        return false;
+    }
+    SharedTiger *aTiger = path[--depth];
+    if (unpackState(aTiger->m_attrs) == state){
+        return true;
+    }
+    SharedTiger *copy = clone(aTiger);
+    copy->m_attrs = packAttrs(unpackAge(aTiger->m_attrs), unpackGender(aTiger->m_attrs), state);
+    Balance::update(copy);
+    publish(copyPath(root, path, depth, id, copy));
+    return true;
+}
+
+// one in order pass collects the alive tigers, which are linked into a new perfectly balanced tree that replaces the
+// old one, O(n). nothing is published if no tiger is dead
+int ConcurrentStreak::removeDead(){
+    lock_guard<mutex> lock(m_writer);
+    vector<pair<int, uint8_t>> alive;
+    int removed = 0;
+    SharedTiger *root = m_root.load();
+    collectAlive(root, alive, removed);
+    if (removed > 0){
+        SharedTiger *rebuilt = buildBalanced(alive, 0, (int)alive.size() - 1);
+        release(root);
+        publish(rebuilt);
+    }
+    return removed;
+}
+
+void ConcurrentStreak::listTigers() const{
+    ReadGuard guard(*this);
+    listTigers(guard.root());
+}
+
+bool ConcurrentStreak::findTiger(int id) const{
+    ReadGuard guard(*this);
+    return find(guard.root(), id) != nullptr;
+}
+
+bool ConcurrentStreak::getTiger(int id, Tiger &tiger) const{
+    ReadGuard guard(*this);
+    SharedTiger *aTiger = find(guard.root(), id);
+    if (aTiger == nullptr){
+        return false;
+    }
+    tiger = Tiger(id, unpackAge(aTiger->m_attrs), unpackGender(aTiger->m_attrs), unpackState(aTiger->m_attrs));
+    return true;
+}
+
+int ConcurrentStreak::countTigerCubs() const{
+    return countBy(CUB);
+}
+
+// the root counts every tiger in the streak, so these are O(1)
+int ConcurrentStreak::countBy(AGE age) const{
+    ReadGuard guard(*this);
+    return guard.root() == nullptr ? 0 : guard.root()->m_ages[age];
+}
+
+int ConcurrentStreak::countBy(GENDER gender) const{
+    ReadGuard guard(*this);
+    return guard.root() == nullptr ? 0 : guard.root()->m_genders[gender];
+}
+
+int ConcurrentStreak::countBy(STATE state) const{
+    ReadGuard guard(*this);
+    return guard.root() == nullptr ? 0 : guard.root()->m_states[state];
+}
+
+int ConcurrentStreak::size() const{
+    ReadGuard guard(*this);
+    SharedTiger *root = guard.root();
+    return root == nullptr ? 0 : root->m_states[ALIVE] + root->m_states[DEAD];
+}
+
+// enters the epoch before the root is loaded
+ConcurrentStreak::ReadGuard::ReadGuard(const ConcurrentStreak &streak) : m_guard(streak.m_epochs), m_streak(streak){
+}
+
+SharedTiger *ConcurrentStreak::ReadGuard::root() const{
+    return m_streak.m_root.load();
+}
+
+// a reference on the published root keeps the whole tree as it is now, whatever the writers do later
+StreakSnapshot ConcurrentStreak::snapshot(){
+    lock_guard<mutex> lock(m_writer);
+    SharedTiger *root = m_root.load();
+    hold(root);
+    return StreakSnapshot(*this, root);
+}
+
+SharedTiger *ConcurrentStreak::newTiger(int id, uint8_t attrs){
+    SharedTiger *aTiger = new SharedTiger;
+    aTiger->m_id = id;
+    aTiger->m_attrs = attrs;
+    aTiger->m_left = nullptr;
+    aTiger->m_right = nullptr;
+    aTiger->m_version = m_version;
+    aTiger->m_refs = 1;
+    Balance::update(aTiger);
+    return aTiger;
+}
+
+// a copy made by the current update, linking the same children
+SharedTiger *ConcurrentStreak::clone(const SharedTiger *aTiger){
+    SharedTiger *copy = new SharedTiger(*aTiger);
+    copy->m_version = m_version;
+    copy->m_refs = 1;
+    hold(copy->m_left);
+    hold(copy->m_right);
+    return copy;
+}
+
+// takes over the caller's link to a node and returns a node the current update may change in its place: the node
+// itself if this update made it, otherwise a copy. the original loses the link
+SharedTiger *ConcurrentStreak::own(SharedTiger *aTiger){
+    if (aTiger->m_version == m_version){
+        return aTiger;
+    }
+    SharedTiger *copy = clone(aTiger);
+    release(aTiger);
+    return copy;
+}
+
+// adds a link to a node
+void ConcurrentStreak::hold(SharedTiger *aTiger){
+    if (aTiger != nullptr){
+        aTiger->m_refs++;
+    }
+}
+
+// drops a link to a node. once the last one is gone the node lets go of its children, and then goes at once if this
+// update made it (it was never published). any other one may be in use by a reader and is retired in the current epoch
+void ConcurrentStreak::release(SharedTiger *aTiger){
+    if (aTiger == nullptr || --aTiger->m_refs > 0){
+        return;
+    }
+    release(aTiger->m_left);
+    release(aTiger->m_right);
+    if (aTiger->m_version == m_version){
+        delete aTiger;
+    }else{
+        m_retired.push_back({m_epochs.current(), aTiger});
+    }
+}
+
+// swaps the new tree in and starts the next epoch, a reader that enters from now on sees the new root. the version
+// moves on as well, so no published node counts as made by the next update
+void ConcurrentStreak::publish(SharedTiger *root){
+    m_root.store(root);
+    m_epochs.advance();
+    m_version++;
+    if (m_retired.size() >= RECLAIMBATCH){
+        reclaim(false);
+    }
+}
+
+// frees every retired node whose epoch is older than the oldest reader still inside
+void ConcurrentStreak::reclaim(bool all){
+    uint64_t oldest = m_epochs.oldest();
+    size_t kept = 0;
+    for (size_t i = 0; i < m_retired.size(); i++){
+        if (all || m_retired[i].first < oldest){
+            delete m_retired[i].second;
+        }else{
+            m_retired[kept++] = m_retired[i];
+        }
+    }
+    m_retired.resize(kept);
+}
+
+SharedTiger *ConcurrentStreak::find(SharedTiger *aTiger, int id){
+    while (aTiger != nullptr && aTiger->m_id != id){
+        aTiger = id < aTiger->m_id ? aTiger->m_left : aTiger->m_right;
+    }
+    return aTiger;
+}
+
+// records the nodes from the root down to the id, or to the last node before where it would be, and returns how many
+// there are. nothing is copied yet, so a write that finds it has nothing to do costs one read-only descent
+int ConcurrentStreak::descend(SharedTiger *root, int id, SharedTiger *path[]){
+    int depth = 0;
+    for (SharedTiger *aTiger = root; aTiger != nullptr; aTiger = id < aTiger->m_id ? aTiger->m_left : aTiger->m_right){
+        path[depth++] = aTiger;
+        if (aTiger->m_id == id){
+            break;
+        }
+    }
+    return depth;
+}
+
+// copies a recorded path bottom-up. every copy links the subtree made below it in place of its child on the side of
+// id, and is rebalanced. the copies hold the other children they share with the originals, so releasing the old root
+// at the end retires the old path and nothing a copy still links. returns the new root
+SharedTiger *ConcurrentStreak::copyPath(SharedTiger *root, SharedTiger *path[], int depth, int id, SharedTiger *subtree){
+    while (depth > 0){
+        SharedTiger *aTiger = path[--depth];
+        SharedTiger *copy = clone(aTiger);
+        SharedTiger *&link = id < aTiger->m_id ? copy->m_left : copy->m_right;
+        release(link);
+        link = subtree;
+        subtree = rebalance(copy);
+    }
+    release(root);
+    return subtree;
+}
+
+// recomputes the subtree counts of a node from its children, the height is AvlBalance's
+void SharedCounts::update(SharedTiger *aTiger){
+    for (int i = 0; i < 3; i++){
+        aTiger->m_ages[i] = 0;
+        aTiger->m_genders[i] = 0;
+    }
+    aTiger->m_states[ALIVE] = 0;
+    aTiger->m_states[DEAD] = 0;
+    aTiger->m_ages[unpackAge(aTiger->m_attrs)]++;
+    aTiger->m_genders[unpackGender(aTiger->m_attrs)]++;
+    aTiger->m_states[unpackState(aTiger->m_attrs)]++;
+    SharedTiger *children[2] = {aTiger->m_left, aTiger->m_right};
+    for (SharedTiger *child : children){
+        if (child != nullptr){
+            for (int i = 0; i < 3; i++){
+                aTiger->m_ages[i] += child->m_ages[i];
+                aTiger->m_genders[i] += child->m_genders[i];
+            }
+            aTiger->m_states[ALIVE] += child->m_states[ALIVE];
+            aTiger->m_states[DEAD] += child->m_states[DEAD];
+        }
+    }
+}
+
+// updates a node this update owns and rebalances it with AvlBalance. the rotations change the node, its child on the
+// heavy side and for a double rotation that child's inner child, so those are owned first and the rotations only ever
+// touch nodes no reader can see
+SharedTiger *ConcurrentStreak::rebalance(SharedTiger *aTiger){
+    Balance::update(aTiger);
+    int imbalance = Balance::checkImbalance(aTiger);
+    if (imbalance > 1){
+        SharedTiger *left = aTiger->m_left = own(aTiger->m_left);
+        if (Balance::checkImbalance(left) < 0){
+            left->m_right = own(left->m_right);
+        }
+    }else if (imbalance < -1){
+        SharedTiger *right = aTiger->m_right = own(aTiger->m_right);
+        if (Balance::checkImbalance(right) > 0){
+            right->m_left = own(right->m_left);
+        }
+    }
+    return Balance::rebalance(aTiger);
+}
+
+// removes the tiger with the smallest id, copies it into id and attrs, and returns the rest of the subtree
+SharedTiger *ConcurrentStreak::removeMin(SharedTiger *aTiger, int &id, uint8_t &attrs){
+    if (aTiger->m_left == nullptr){
+        id = aTiger->m_id;
+        attrs = aTiger->m_attrs;
+        SharedTiger *right = aTiger->m_right;
+        hold(right);
+        release(aTiger);
+        return right;
+    }
+    aTiger = own(aTiger);
+    aTiger->m_left = removeMin(aTiger->m_left, id, attrs);
+    return rebalance(aTiger);
+}
+
+// in order traversal that appends the id and attributes of every alive tiger to alive and counts the dead ones
+void ConcurrentStreak::collectAlive(const SharedTiger *aTiger, vector<pair<int, uint8_t>> &alive, int &removed){
+    if (aTiger != nullptr){
+        collectAlive(aTiger->m_left, alive, removed);
+        if (unpackState(aTiger->m_attrs) == DEAD){
+            removed++;
+        }else{
+            alive.push_back({aTiger->m_id, aTiger->m_attrs});
+        }
+        collectAlive(aTiger->m_right, alive, removed);
+    }
+}
+
+// links new nodes for tigers[lo..hi], in id order, into a perfectly balanced tree and returns its root
+SharedTiger *ConcurrentStreak::buildBalanced(const vector<pair<int, uint8_t>> &tigers, int lo, int hi){
+    if (lo > hi){
+        return nullptr;
+    }
+    int mid = lo + (hi - lo + 1) / 2;
+    SharedTiger *root = newTiger(tigers[mid].first, tigers[mid].second);
+    root->m_left = buildBalanced(tigers, lo, mid - 1);
+    root->m_right = buildBalanced(tigers, mid + 1, hi);
+    Balance::update(root);
+    return root;
+}
+
+// lists tigers and their elements in the same format as Streak, in order traversal
+void ConcurrentStreak::listTigers(const SharedTiger *aTiger){
+    if (aTiger != nullptr){
+        listTigers(aTiger->m_left);
+        Tiger tiger(aTiger->m_id, unpackAge(aTiger->m_attrs), unpackGender(aTiger->m_attrs),
+                    unpackState(aTiger->m_attrs));
+        cout << tiger.getID() << ":" << tiger.getAgeStr() << ":" << tiger.getGenderStr() << ":" << tiger.getStateStr()
+        << endl;
+        listTigers(aTiger->m_right);
+    }
+}
+
+// returns the # of tigers with an id smaller than id below aTiger, one descent using the subtree counts
+int ConcurrentStreak::rank(const SharedTiger *aTiger, int id){
+    int smaller = 0;
+    while (aTiger != nullptr){
+        if (aTiger->m_id < id){
+            const SharedTiger *left = aTiger->m_left;
+            smaller += 1 + (left == nullptr ? 0 : left->m_states[ALIVE] + left->m_states[DEAD]);
+            aTiger = aTiger->m_right;
+        }else{
+            aTiger = aTiger->m_left;
+        }
+    }
+    return smaller;
+}
+
+StreakSnapshot::StreakSnapshot(ConcurrentStreak &streak, SharedTiger *root) : m_streak(&streak), m_root(root){
+}
+
+StreakSnapshot::StreakSnapshot(const StreakSnapshot &other) : m_streak(other.m_streak), m_root(other.m_root){
+    lock_guard<mutex> lock(m_streak->m_writer);
+    ConcurrentStreak::hold(m_root);
+}
+
+StreakSnapshot &StreakSnapshot::operator=(const StreakSnapshot &other){
+    if (this != &other){
+        {
+            lock_guard<mutex> lock(other.m_streak->m_writer);
+            ConcurrentStreak::hold(other.m_root);
+        }
+        {
+            lock_guard<mutex> lock(m_streak->m_writer);
+            m_streak->release(m_root);
+        }
+        m_streak = other.m_streak;
+        m_root = other.m_root;
+    }
+    return *this;
+}
+
+// the nodes only this snapshot still held are retired, and freed by a later publish
+StreakSnapshot::~StreakSnapshot(){
+    lock_guard<mutex> lock(m_streak->m_writer);
+    m_streak->release(m_root);
+}
+
+void StreakSnapshot::listTigers() const{
+    ConcurrentStreak::listTigers(m_root);
+}
+
+bool StreakSnapshot::findTiger(int id) const{
+    return ConcurrentStreak::find(m_root, id) != nullptr;
+}
+
+bool StreakSnapshot::getTiger(int id, Tiger &tiger) const{
+    SharedTiger *aTiger = ConcurrentStreak::find(m_root, id);
+    if (aTiger == nullptr){
+        return false;
+    }
+    tiger = Tiger(id, unpackAge(aTiger->m_attrs), unpackGender(aTiger->m_attrs), unpackState(aTiger->m_attrs));
+    return true;
+}
+
+int StreakSnapshot::countTigerCubs() const{
+    return countBy(CUB);
+}
+
+int StreakSnapshot::countBy(AGE age) const{
+    return m_root == nullptr ? 0 : m_root->m_ages[age];
+}
+
+int StreakSnapshot::countBy(GENDER gender) const{
+    return m_root == nullptr ? 0 : m_root->m_genders[gender];
+}
+
+int StreakSnapshot::countBy(STATE state) const{
+    return m_root == nullptr ? 0 : m_root->m_states[state];
+}
+
+int StreakSnapshot::size() const{
+    return m_root == nullptr ? 0 : m_root->m_states[ALIVE] + m_root->m_states[DEAD];
+}
+
+int StreakSnapshot::rank(int id) const{
+    return ConcurrentStreak::rank(m_root, id);
+}
+
+int StreakSnapshot::countInRange(int lo, int hi) const{
+    if (lo > hi){
+        return 0;
+    }
+    return (hi >= MAXID ? size() : ConcurrentStreak::rank(m_root, hi + 1)) - ConcurrentStreak::rank(m_root, lo);
+}
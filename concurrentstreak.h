@@ -0,0 +1,150 @@
+#ifndef CONCURRENTSTREAK_H
+#define CONCURRENTSTREAK_H
+#include "streak.h"
+#include "epoch.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+// a node of ConcurrentStreak. it is never changed once a root that reaches it is published, an update copies it
+// instead (m_version tells the copies the current update made from nodes readers may hold). nodes are shared by the
+// published tree and any snapshots, m_refs counts the links to a node and it is retired when the last one goes
+struct SharedTiger{
+    int m_id;
+    uint8_t m_attrs;//age | gender << 2 | state << 4
+    int m_height;//the height of node in the BST
+    SharedTiger *m_left;
+    SharedTiger *m_right;
+    int m_ages[3];//number of tigers of each AGE in the subtree rooted here
+    int m_genders[3];//number of tigers of each GENDER in the subtree rooted here
+    int m_states[2];//number of tigers of each STATE in the subtree rooted here
+    uint64_t m_version;//the update that made this node
+    int m_refs;//parents, the published root and snapshot roots pointing here, only changed under the writer mutex
+};
+
+// the augmentation of ConcurrentStreak for AvlBalance, recomputes the subtree counts of a node from its children
+struct SharedCounts{
+    static void update(SharedTiger *aTiger);
+};
+
+class ConcurrentStreak;
+
+// an immutable point-in-time view of a ConcurrentStreak. taking one is O(1): it holds a reference on the root that
+// was published at the time, and the writers copy whatever they change from then on. queries need no lock and are safe
+// from any thread. copying a handle is O(1) as well. every handle has to be gone before its ConcurrentStreak is
+class StreakSnapshot{
+public:
+    StreakSnapshot(const StreakSnapshot &other);
+    StreakSnapshot &operator=(const StreakSnapshot &other);
+    ~StreakSnapshot();
+    void listTigers() const;
+    bool findTiger(int id) const;//returns true if the tiger is in the snapshot
+    bool getTiger(int id, Tiger &tiger) const;//copies the tiger with this id into tiger, returns false if there is none
+    int countTigerCubs() const;// returns the # of cubs in the snapshot
+    int countBy(AGE age) const;
+    int countBy(GENDER gender) const;
+    int countBy(STATE state) const;
+    int size() const;
+    int rank(int id) const;// returns the # of tigers with an id smaller than id, O(log n)
+    int countInRange(int lo, int hi) const;// returns the # of tigers with lo <= id <= hi, O(log n)
+    // calls visitor(const Tiger&) on every tiger with lo <= id <= hi in increasing id order, O(log n + k)
+    template <class Visitor>
+    void forEachInRange(int lo, int hi, Visitor &&visitor) const{
+        forEachInRange(lo, hi, visitor, m_root);
+    }
+private:
+    friend class ConcurrentStreak;
+    friend class Tester;
+    StreakSnapshot(ConcurrentStreak &streak, SharedTiger *root);
+    ConcurrentStreak *m_streak;
+    SharedTiger *m_root;//holds one reference
+
+    template <class Visitor>
+    static void forEachInRange(int lo, int hi, Visitor &visitor, const SharedTiger *aTiger);
+};
+
+
+// the Streak API for many reader threads and any number of writer threads. readers never lock or wait: they load the
+// current root and walk an immutable tree. writers take turns on a mutex, copy the path they change (and the nodes a
+// rotation touches), and publish the new root with one atomic store. the nodes the new tree no longer uses are
+// retired and freed by epoch based reclamation, once no reader that could still see them is left
+class ConcurrentStreak{
+public:
+    friend class Tester;
+    friend class StreakSnapshot;
+    ConcurrentStreak();
+    ~ConcurrentStreak();
+    ConcurrentStreak(const ConcurrentStreak&) = delete;
+    ConcurrentStreak &operator=(const ConcurrentStreak&) = delete;
+    // writers
+    RESULT insert(const Tiger& tiger);
+    void clear();
+    bool remove(int id);// returns false if the id is not in the tree
+    bool setState(int id, STATE state);
+    int removeDead();//remove all dead tigers from the tree, returns how many were removed
+    // readers, safe from any thread at any time
+    void listTigers() const;
+    bool findTiger(int id) const;//returns true if the tiger is in tree
+    bool getTiger(int id, Tiger &tiger) const;//copies the tiger with this id into tiger, returns false if there is none
+    int countTigerCubs() const;// returns the # of cubs in the streak
+    int countBy(AGE age) const;
+    int countBy(GENDER gender) const;
+    int countBy(STATE state) const;
+    int size() const;
+    StreakSnapshot snapshot();// the current tree as an immutable handle, O(1)
+private:
+    // a reader's claim on one epoch slot, released when the read is done
+    class ReadGuard{
+    public:
+        explicit ReadGuard(const ConcurrentStreak &streak);
+        SharedTiger *root() const;
+    private:
+        EpochDomain::Guard m_guard;
+        const ConcurrentStreak &m_streak;
+    };
+
+    atomic<SharedTiger*> m_root;//the published tree
+    mutable EpochDomain m_epochs;//advanced after every publish
+    mutex m_writer;//writers take turns, readers never touch it
+    uint64_t m_version;//the update in progress, bumped by every publish. only used under m_writer
+    vector<pair<uint64_t, SharedTiger*>> m_retired;//nodes out of the tree, with the epoch they were retired in
+
+    typedef AvlBalance<SharedTiger, SharedCounts> Balance;//the balancing of Streak, on nodes this update owns
+
+    SharedTiger *newTiger(int id, uint8_t attrs);
+    SharedTiger *clone(const SharedTiger *aTiger);
+    SharedTiger *own(SharedTiger *aTiger);
+    static void hold(SharedTiger *aTiger);
+    void release(SharedTiger *aTiger);
+    void publish(SharedTiger *root);
+    void reclaim(bool all);
+    static SharedTiger *find(SharedTiger *aTiger, int id);
+    static int descend(SharedTiger *root, int id, SharedTiger *path[]);
+    SharedTiger *copyPath(SharedTiger *root, SharedTiger *path[], int depth, int id, SharedTiger *subtree);
+    SharedTiger *rebalance(SharedTiger *aTiger);
+    SharedTiger *removeMin(SharedTiger *aTiger, int &id, uint8_t &attrs);
+    static void collectAlive(const SharedTiger *aTiger, vector<pair<int, uint8_t>> &alive, int &removed);
+    SharedTiger *buildBalanced(const vector<pair<int, uint8_t>> &tigers, int lo, int hi);
+    static void listTigers(const SharedTiger *aTiger);
+    static int rank(const SharedTiger *aTiger, int id);
+};
+
+// in order traversal that skips every subtree outside [lo, hi], like Streak::forEachInRange
+template <class Visitor>
+void StreakSnapshot::forEachInRange(int lo, int hi, Visitor &visitor, const SharedTiger *aTiger){
+    while (aTiger != nullptr){
+        if (aTiger->m_id < lo){
+            aTiger = aTiger->m_right;
+        }else if (aTiger->m_id > hi){
+            aTiger = aTiger->m_left;
+        }else{
+            forEachInRange(lo, hi, visitor, aTiger->m_left);
+            const Tiger tiger(aTiger->m_id, unpackAge(aTiger->m_attrs), unpackGender(aTiger->m_attrs),
+                              unpackState(aTiger->m_attrs));
+            visitor(tiger);
+            aTiger = aTiger->m_right;
+        }
+    }
+}
+#endif
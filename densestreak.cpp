@@ -0,0 +1,169 @@
+#include "densestreak.h"
+
+// constructor, allocates every slot once
+DenseStreak::DenseStreak(){
+    m_attrs.assign(IDRANGE, 0);
+    clear();
+}
+
+// checks if id is within MINID and MAXID and if its slot is free
+RESULT DenseStreak::insert(const Tiger& tiger){
+    if (tiger.getID() < MINID || tiger.getID() > MAXID){
+        return OUTOFRANGE;
+    }
+    int key = tiger.getID() - MINID;
+    if (occupied(key)){
+        return DUPLICATE;
+    }
+    m_occupied[key >> 6] |= uint64_t(1) << (key & 63);
+    m_attrs[key] = packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState());
+    count(m_attrs[key], 1);
+    return INSERTED;
+}
+
+// empties the bitmap, the slots keep their old bytes since nothing reads an empty slot
+void DenseStreak::clear(){
+    m_occupied.assign((IDRANGE + 63) / 64, 0);
+    for (int i = 0; i < 3; i++){
+        m_ages[i] = 0;
+        m_genders[i] = 0;
+    }
+    m_states[ALIVE] = 0;
+    m_states[DEAD] = 0;
+}
+
+bool DenseStreak::remove(int id){
+    if (id < MINID || id > MAXID){
+        return false;
+    }
+    int key = id - MINID;
+    if (!occupied(key)){
+        return false;
+    }
+    m_occupied[key >> 6] &= ~(uint64_t(1) << (key & 63));
+    count(m_attrs[key], -1);
+    return true;
+}
+
+void DenseStreak::dumpTree() const{
+    for (size_t word = 0; word < m_occupied.size(); word++){
+        for (uint64_t bits = m_occupied[word]; bits != 0; bits &= bits - 1){
+            cout << "(" << MINID + word * 64 + __builtin_ctzll(bits) << ")";
+        }
+    }
+}
+
+// lists tigers and their elements in the same format as Streak, every set bit of the bitmap in order
+void DenseStreak::listTigers() const{
+    for (size_t word = 0; word < m_occupied.size(); word++){
+        for (uint64_t bits = m_occupied[word]; bits != 0; bits &= bits - 1){
+            int key = word * 64 + __builtin_ctzll(bits);
+            uint8_t attrs = m_attrs[key];
+            Tiger tiger(key + MINID, unpackAge(attrs), unpackGender(attrs), unpackState(attrs));
+            cout << tiger.getID() << ":" << tiger.getAgeStr() << ":" << tiger.getGenderStr() << ":"
+            << tiger.getStateStr() << endl;
+        }
+    }
+}
+
+// sets state of specific tiger; checks if it exists
+bool DenseStreak::setState(int id, STATE state){
+    if (!findTiger(id)){
+        return false;
+    }
+    uint8_t &attrs = m_attrs[id - MINID];
+    count(attrs, -1);
+    attrs = packAttrs(unpackAge(attrs), unpackGender(attrs), state);
+    count(attrs, 1);
+    return true;
+}
+
+// one pass over the bitmap, only the occupied slots are read
+int DenseStreak::removeDead(){
+    int removed = 0;
+    for (size_t word = 0; word < m_occupied.size(); word++){
+        uint64_t dead = 0;
+        for (uint64_t bits = m_occupied[word]; bits != 0; bits &= bits - 1){
+            int bit = __builtin_ctzll(bits);
+            uint8_t attrs = m_attrs[word * 64 + bit];
+            if (unpackState(attrs) == DEAD){
+                dead |= uint64_t(1) << bit;
+                count(attrs, -1);
+                removed++;
+            }
+        }
+        m_occupied[word] &= ~dead;
+    }
+    return removed;
+}
+
+// returns true if tiger is in streak. returns false if it isn't
+bool DenseStreak::findTiger(int id) const{
+    return id >= MINID && id <= MAXID && occupied(id - MINID);
+}
+
+bool DenseStreak::getTiger(int id, Tiger &tiger) const{
+    if (!findTiger(id)){
+        return false;
+    }
+    uint8_t attrs = m_attrs[id - MINID];
+    tiger = Tiger(id, unpackAge(attrs), unpackGender(attrs), unpackState(attrs));
+    return true;
+}
+
+int DenseStreak::countTigerCubs() const{
+    return m_ages[CUB];
+}
+
+int DenseStreak::countBy(AGE age) const{
+    return m_ages[age];
+}
+
+int DenseStreak::countBy(GENDER gender) const{
+    return m_genders[gender];
+}
+
+int DenseStreak::countBy(STATE state) const{
+    return m_states[state];
+}
+
+int DenseStreak::size() const{
+    return m_ages[CUB] + m_ages[YOUNG] + m_ages[OLD];
+}
+
+int DenseStreak::countInRange(int lo, int hi) const{
+    if (lo < MINID){
+        lo = MINID;
+    }
+    if (hi > MAXID){
+        hi = MAXID;
+    }
+    if (lo > hi){
+        return 0;
+    }
+    return countBelow(hi - MINID + 1) - countBelow(lo - MINID);
+}
+
+bool DenseStreak::occupied(int key) const{
+    return (m_occupied[key >> 6] >> (key & 63)) & 1;
+}
+
+// adds delta to the count of the age, gender and state in attrs
+void DenseStreak::count(uint8_t attrs, int delta){
+    m_ages[unpackAge(attrs)] += delta;
+    m_genders[unpackGender(attrs)] += delta;
+    m_states[unpackState(attrs)] += delta;
+}
+
+// the # of tigers in the slots below key, whole words by popcount and the last word masked
+int DenseStreak::countBelow(int key) const{
+    int below = 0;
+    int words = key >> 6;
+    for (int word = 0; word < words; word++){
+        below += __builtin_popcountll(m_occupied[word]);
+    }
+    if ((key & 63) != 0){
+        below += __builtin_popcountll(m_occupied[words] & ((uint64_t(1) << (key & 63)) - 1));
+    }
+    return below;
+}
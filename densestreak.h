@@ -0,0 +1,44 @@
+#ifndef DENSESTREAK_H
+#define DENSESTREAK_H
+#include "streak.h"
+#include <cstdint>
+#include <vector>
+
+// number of possible ids, MINID..MAXID
+const int IDRANGE = MAXID - MINID + 1;
+
+// the Streak API on a flat array with one slot per possible id. slot id - MINID holds the tiger's age, gender and state
+// in one byte, and an occupancy bitmap tells which slots hold a tiger. insert, remove, findTiger and setState are one
+// array access, ordered traversals scan the bitmap 64 ids at a time. the memory is fixed at about 100KB whatever the
+// number of tigers, so this beats a tree once a streak holds a sizeable part of every id
+class DenseStreak{
+public:
+    friend class Tester;
+    DenseStreak();
+    RESULT insert(const Tiger& tiger);
+    void clear();
+    bool remove(int id);// returns false if the id is not in the streak
+    void dumpTree() const;// there is no tree, prints every id in order as (id)
+    void listTigers() const;
+    bool setState(int id, STATE state);
+    int removeDead();//remove all dead tigers from the streak, returns how many were removed
+    bool findTiger(int id) const;//returns true if the tiger is in streak
+    bool getTiger(int id, Tiger &tiger) const;//copies the tiger with this id into tiger, returns false if there is none
+    int countTigerCubs() const;// returns the # of cubs in the streak
+    int countBy(AGE age) const;
+    int countBy(GENDER gender) const;
+    int countBy(STATE state) const;
+    int size() const;
+    int countInRange(int lo, int hi) const;// returns the # of tigers with lo <= id <= hi, by popcount over the bitmap
+private:
+    vector<uint8_t> m_attrs;//age | gender << 2 | state << 4 of every slot, meaningless if the slot is empty
+    vector<uint64_t> m_occupied;//bit id - MINID is set if the streak has a tiger with that id
+    int m_ages[3];//number of tigers of each AGE
+    int m_genders[3];//number of tigers of each GENDER
+    int m_states[2];//number of tigers of each STATE
+
+    bool occupied(int key) const;
+    void count(uint8_t attrs, int delta);
+    int countBelow(int key) const;
+};
+#endif
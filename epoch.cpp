@@ -0,0 +1,69 @@
+#include "epoch.h"
+#include <thread>
+#include <functional>
+
+EpochDomain::EpochDomain(){
+    m_epoch.store(1);
+    for (Slot &slot : m_slots){
+        slot.m_epoch.store(IDLE);
+    }
+    m_overflow.m_epoch.store(IDLE);
+    m_overflowReaders = 0;
+}
+
+// claims a free slot with the current epoch before any pointer is loaded. the search starts at a slot picked by
+// thread, so threads rarely compete for one. a thread that went once around all of them without a free one joins the
+// overflow slot under its lock instead of spinning until one is given back
+EpochDomain::Guard::Guard(EpochDomain &domain) : m_domain(domain){
+    static thread_local size_t hint = hash<thread::id>()(this_thread::get_id());
+    uint64_t epoch = domain.m_epoch.load();
+    int first = hint % READERSLOTS;
+    for (int i = 0; i < READERSLOTS; i++){
+        m_slot = (first + i) % READERSLOTS;
+        uint64_t idle = IDLE;
+        if (domain.m_slots[m_slot].m_epoch.compare_exchange_strong(idle, epoch)){
+            return;
+        }
+    }
+    m_slot = OVERFLOWSLOT;
+    lock_guard<mutex> lock(domain.m_overflowLock);
+    if (domain.m_overflowReaders++ == 0){
+        domain.m_overflow.m_epoch.store(epoch);
+    }
+}
+
+EpochDomain::Guard::~Guard(){
+    if (m_slot != OVERFLOWSLOT){
+        m_domain.m_slots[m_slot].m_epoch.store(IDLE, memory_order_release);
+        return;
+    }
+    lock_guard<mutex> lock(m_domain.m_overflowLock);
+    if (--m_domain.m_overflowReaders == 0){
+        m_domain.m_overflow.m_epoch.store(IDLE, memory_order_release);
+    }
+}
+
+uint64_t EpochDomain::current() const{
+    return m_epoch.load();
+}
+
+uint64_t EpochDomain::advance(){
+    return m_epoch.fetch_add(1);
+}
+
+// a thread that entered in the epoch a node was retired in may have loaded a pointer to it before it was taken out,
+// one that entered later can not
+uint64_t EpochDomain::oldest() const{
+    uint64_t oldest = m_epoch.load();
+    for (const Slot &slot : m_slots){
+        uint64_t epoch = slot.m_epoch.load();
+        if (epoch != IDLE && epoch < oldest){
+            oldest = epoch;
+        }
+    }
+    uint64_t epoch = m_overflow.m_epoch.load();
+    if (epoch != IDLE && epoch < oldest){
+        oldest = epoch;
+    }
+    return oldest;
+}
@@ -0,0 +1,54 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+using namespace std;
+
+// the number of threads that can be inside an EpochDomain with a slot of their own, the rest share the overflow slot
+const int READERSLOTS = 128;
+// retired nodes are only looked at once this many have piled up
+const size_t RECLAIMBATCH = 256;
+
+// epoch based reclamation for the concurrent streaks. a thread enters with a Guard before it loads any pointer into
+// the structure and leaves once it holds none. a node taken out of the structure is tagged with the current epoch,
+// and it can be freed once oldest() has moved past the tag: every thread that could still see it has left
+class EpochDomain{
+public:
+    friend class Tester;
+    EpochDomain();
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain &operator=(const EpochDomain&) = delete;
+    // a thread's claim on one slot, with the epoch it entered in, released when the guard goes
+    class Guard{
+    public:
+        friend class Tester;
+        explicit Guard(EpochDomain &domain);
+        ~Guard();
+        Guard(const Guard&) = delete;
+        Guard &operator=(const Guard&) = delete;
+    private:
+        EpochDomain &m_domain;
+        int m_slot;//OVERFLOWSLOT for the shared slot
+    };
+    uint64_t current() const;// the epoch a thread entering now gets
+    uint64_t advance();// starts the next epoch, returns the one that ended
+    uint64_t oldest() const;// the epoch of the oldest thread inside, current() if there is none
+private:
+    // the epoch a thread entered in, IDLE if the slot is free. one slot per cache line
+    struct alignas(64) Slot{
+        atomic<uint64_t> m_epoch;
+    };
+    static const uint64_t IDLE = 0;
+    static const int OVERFLOWSLOT = -1;
+
+    atomic<uint64_t> m_epoch;//starts at 1
+    Slot m_slots[READERSLOTS];
+    // the slot of the threads that found every other one taken. it keeps the epoch of the first of them until the
+    // last one leaves, which is older than any of theirs, so it holds back reclamation a little longer but never too
+    // little
+    Slot m_overflow;
+    mutex m_overflowLock;//guards m_overflowReaders and the changes of m_overflow
+    int m_overflowReaders;
+};
+#endif
@@ -0,0 +1,84 @@
+#include "feed.h"
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+// parses one integer field ending at the separator, moves first past the separator. returns false if the field is not
+// a whole integer followed by the separator
+static bool field(const char *&first, const char *last, char separator, int &value){
+    from_chars_result result = from_chars(first, last, value);
+    if (result.ec != errc() || result.ptr == last || *result.ptr != separator){
+        return false;
+    }
+    first = result.ptr + 1;
+    return true;
+}
+
+static void insertBatch(Streak &streak, vector<Tiger> &batch, IngestCounts &counts){
+    int inserted = streak.insertBatch(batch);
+    counts.m_inserted += inserted;
+    counts.m_duplicates += batch.size() - inserted;
+    batch.clear();
+}
+
+void parseLine(const char *first, const char *last, vector<Tiger> &batch, IngestCounts &counts){
+    if (first != last && last[-1] == '\r'){
+        last--;
+    }
+    if (first == last){
+        return;
+    }
+    counts.m_lines++;
+    int id, age, gender, state;
+    if (!field(first, last, ',', id) || !field(first, last, ',', age) || !field(first, last, ',', gender)){
+        counts.m_malformed++;
+        return;
+    }
+    from_chars_result result = from_chars(first, last, state);
+    if (result.ec != errc() || result.ptr != last){
+        counts.m_malformed++;
+    }else if (id < MINID || id > MAXID){
+        counts.m_outOfRange++;
+    }else if (age < CUB || age > OLD || gender < MALE || gender > UNKNOWN || state < ALIVE || state > DEAD){
+        counts.m_badEnum++;
+    }else{
+        batch.emplace_back(id, static_cast<AGE>(age), static_cast<GENDER>(gender), static_cast<STATE>(state));
+    }
+}
+
+// a line cut by the end of a block is moved to the front and the next block is read after it, so nothing is allocated
+// per line
+bool ingestFeed(int file, Streak &streak, IngestCounts &counts, size_t block, size_t batchSize){
+    vector<Tiger> batch;
+    batch.reserve(batchSize);
+    vector<char> buffer(max(block, (size_t)1));
+    size_t kept = 0;
+    while (true){
+        if (kept == buffer.size()){
+            buffer.resize(buffer.size() * 2);//a line longer than a block
+        }
+        ssize_t got = read(file, buffer.data() + kept, buffer.size() - kept);
+        if (got < 0){
+            return false;
+        }
+        counts.m_bytes += got;
+        const char *first = buffer.data();
+        const char *last = buffer.data() + kept + got;
+        const char *newline;
+        while ((newline = static_cast<const char*>(memchr(first, '\n', last - first))) != nullptr){
+            parseLine(first, newline, batch, counts);
+            first = newline + 1;
+            if (batch.size() >= batchSize){
+                insertBatch(streak, batch, counts);
+            }
+        }
+        if (got == 0){
+            parseLine(first, last, batch, counts);//the last line may have no newline
+            break;
+        }
+        kept = last - first;
+        memmove(buffer.data(), first, kept);
+    }
+    insertBatch(streak, batch, counts);
+    return true;
+}
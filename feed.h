@@ -0,0 +1,28 @@
+#ifndef FEED_H
+#define FEED_H
+#include "streak.h"
+#include <vector>
+
+const size_t INGESTBLOCK = 1 << 20;//bytes read at once
+const size_t INGESTBATCH = 1 << 16;//tigers handed to insertBatch at once
+
+// what became of the lines of a feed
+struct IngestCounts{
+    long m_bytes = 0;
+    long m_lines = 0;
+    long m_inserted = 0;
+    long m_duplicates = 0;//well formed, but the id was in the streak or earlier in the feed already
+    long m_malformed = 0;//not four comma separated integers
+    long m_outOfRange = 0;//id outside MINID..MAXID
+    long m_badEnum = 0;//age, gender or state outside its enum
+};
+
+// parses one id,age,gender,state line without its newline into batch, or counts why it was turned away. a carriage
+// return at the end is ignored and empty lines are skipped
+void parseLine(const char *first, const char *last, vector<Tiger> &batch, IngestCounts &counts);
+
+// reads a feed from file to its end in blocks of block bytes, parses each line in place and inserts the tigers into
+// streak batch at a time. a line longer than a block grows the buffer, and the last line may have no newline. returns
+// false if the file can not be read
+bool ingestFeed(int file, Streak &streak, IngestCounts &counts, size_t block = INGESTBLOCK, size_t batch = INGESTBATCH);
+#endif
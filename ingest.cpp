@@ -0,0 +1,58 @@
+// loads a roster feed of id,age,gender,state lines into a Streak and reports how fast it went and what it turned away.
+// age, gender and state are the numbers of their enum values (AGE 0-2, GENDER 0-2, STATE 0-1). the feed is read in
+// large blocks, each line is parsed in place with from_chars, and the tigers go in through insertBatch a batch at a
+// time, so nothing is allocated per line and the tree is built from sorted runs instead of one insert per tiger. the
+// parsing is ingestFeed in feed.h
+//
+//     ./ingest [feed] [-o snapshot]
+//
+// reads standard input if no feed is given, and saves the streak as a binary snapshot if -o is
+#include "feed.h"
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]){
+    const char *feed = nullptr;
+    const char *snapshot = nullptr;
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+            snapshot = argv[++i];
+        }else if (feed == nullptr && argv[i][0] != '-'){
+            feed = argv[i];
+        }else{
+            cerr << "usage: " << argv[0] << " [feed] [-o snapshot]" << endl;
+            return 2;
+        }
+    }
+    int file = feed == nullptr ? STDIN_FILENO : open(feed, O_RDONLY);
+    if (file < 0){
+        cerr << "can not open " << feed << endl;
+        return 1;
+    }
+    auto startTime = chrono::steady_clock::now();
+    Streak streak;
+    IngestCounts counts;
+    bool fed = ingestFeed(file, streak, counts);
+    if (feed != nullptr){
+        close(file);
+    }
+    if (!fed){
+        cerr << "can not read " << (feed == nullptr ? "standard input" : feed) << endl;
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    cout << counts.m_lines << " lines (" << counts.m_bytes << " bytes) in " << seconds * 1000 << " ms, "
+         << (long)(counts.m_lines / max(seconds, 1e-9)) << " lines/s" << endl;
+    cout << counts.m_inserted << " inserted, " << counts.m_duplicates << " duplicates, "
+         << counts.m_malformed + counts.m_outOfRange + counts.m_badEnum << " rejected (" << counts.m_malformed
+         << " malformed, " << counts.m_outOfRange << " id out of range, " << counts.m_badEnum << " bad age/gender/state)"
+         << endl;
+    cout << streak.size() << " tigers, " << streak.countTigerCubs() << " cubs, " << streak.countBy(DEAD) << " dead" << endl;
+    if (snapshot != nullptr && !streak.save(snapshot)){
+        cerr << "can not write " << snapshot << endl;
+        return 1;
+    }
+    return 0;
+}
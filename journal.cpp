@@ -0,0 +1,318 @@
+#include "journal.h"
+#include <fstream>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+// reads a little endian u32
+static uint32_t readField(const uint8_t *bytes){
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static void writeField(uint8_t *bytes, uint32_t value){
+    for (int byte = 0; byte < 4; byte++){
+        bytes[byte] = (value >> (8 * byte)) & 0xFF;
+    }
+}
+
+StreakJournal::StreakJournal(){
+    m_streak = nullptr;
+    m_file = -1;
+    m_batch = JOURNALBATCH;
+    m_delay = JOURNALDELAY;
+    m_crc = 0;
+    m_end = 0;
+    m_appended = 0;
+    m_durable = 0;
+    m_syncs = 0;
+    m_stopping = false;
+    m_failed = false;
+}
+
+StreakJournal::~StreakJournal(){
+    close();
+}
+
+// the records are checked one by one along the crc chain, so replay stops at the first one that was not written
+// whole. the journal is then cut right after the last good record and appended to from there, or started over if it
+// was not a journal of this snapshot
+int StreakJournal::recover(const string &snapshot, const string &journal, Streak &streak, int batch, int delay){
+    close();
+    m_snapshot = snapshot;
+    m_path = journal;
+    m_batch = max(1, batch);
+    m_delay = delay;
+    streak.attach(nullptr);
+    uint32_t base = 0;
+    if (ifstream(snapshot).good()){
+        if (!streak.load(snapshot)){
+            return -1;
+        }
+        base = snapshotBase(snapshot);
+    }else{
+        streak.clear();
+    }
+    ifstream in(journal, ios::binary);
+    const vector<uint8_t> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    int replayed = 0;
+    size_t valid = 0;
+    uint32_t crc = 0;
+    if (bytes.size() >= (size_t)JOURNALHEADER && readField(&bytes[0]) == JOURNALMAGIC
+        && readField(&bytes[4]) == JOURNALVERSION && readField(&bytes[8]) == base
+        && crc32(bytes.data(), 12) == readField(&bytes[12])){
+        crc = readField(&bytes[12]);
+        valid = JOURNALHEADER;
+        while (valid + JOURNALRECORD <= bytes.size()){
+            uint32_t next = crc32(&bytes[valid], 4, crc);
+            uint32_t payload = readField(&bytes[valid]);
+            int id = (payload & 0x1FFFF) + MINID;
+            uint8_t attrs = (payload >> 17) & 0xFF;
+            uint32_t type = payload >> 25;
+            if (next != readField(&bytes[valid + 4]) || type > REMOVEDEADRECORD || id > MAXID || !validAttrs(attrs)){
+                break;
+            }
+            if (type == INSERTRECORD){
+                streak.insert(Tiger(id, unpackAge(attrs), unpackGender(attrs), unpackState(attrs)));
+            }else if (type == REMOVERECORD){
+                streak.remove(id);
+            }else if (type == STATERECORD){
+                streak.setState(id, unpackState(attrs));
+            }else{
+                streak.removeDead();
+            }
+            crc = next;
+            valid += JOURNALRECORD;
+            replayed++;
+        }
+    }
+    if (valid > 0){
+        m_file = ::open(journal.c_str(), O_WRONLY);
+        if (m_file < 0 || ftruncate(m_file, valid) != 0 || fdatasync(m_file) != 0){
+            if (m_file >= 0){
+                ::close(m_file);
+                m_file = -1;
+            }
+            return -1;
+        }
+        m_crc = crc;
+        m_end = valid;
+    }else if (!start(base)){
+        return -1;
+    }
+    m_pending.clear();
+    m_appended = 0;
+    m_durable = 0;
+    m_syncs = 0;
+    m_stopping = false;
+    m_failed = false;
+    m_flusher = thread(&StreakJournal::flushLoop, this);
+    m_streak = &streak;
+    streak.attach(this);
+    return replayed;
+}
+
+// the records not yet on disk are in the streak and go into the snapshot with it, so they are dropped. a compaction
+// that fails leaves an old journal that does not hold the update the streak asked for it after, whether the snapshot
+// could not be saved or the new journal could not be started on it, so the journal closes and is marked failed
+bool StreakJournal::compact(){
+    if (m_streak == nullptr){
+        return false;
+    }
+    {
+        lock_guard<mutex> flushing(m_flushing);
+        if (m_streak->save(m_snapshot)){
+            int old = m_file;
+            uint64_t end = m_end;
+            if (start(snapshotBase(m_snapshot))){
+                ::close(old);
+                lock_guard<mutex> lock(m_lock);
+                m_pending.clear();
+                m_durable = m_appended;
+                return true;
+            }
+            m_file = old;
+            m_end = end;
+        }
+    }
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_failed = true;
+    }
+    close();
+    return false;
+}
+
+// a flush takes everything appended before it started, so once the flush this call waited for is done, so is every
+// record appended before the call
+bool StreakJournal::sync(){
+    bool flushed = flush();
+    lock_guard<mutex> lock(m_lock);
+    return flushed && !m_failed;
+}
+
+bool StreakJournal::close(){
+    if (m_streak == nullptr){
+        return true;
+    }
+    bool flushed = flush();
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_stopping = true;
+    }
+    m_changed.notify_all();
+    m_flusher.join();
+    ::close(m_file);
+    m_file = -1;
+    m_streak->attach(nullptr);
+    m_streak = nullptr;
+    return flushed;
+}
+
+uint64_t StreakJournal::appended() const{
+    lock_guard<mutex> lock(m_lock);
+    return m_appended;
+}
+
+uint64_t StreakJournal::durable() const{
+    lock_guard<mutex> lock(m_lock);
+    return m_durable;
+}
+
+uint64_t StreakJournal::syncs() const{
+    lock_guard<mutex> lock(m_lock);
+    return m_syncs;
+}
+
+// appends to the pending records, and flushes right away once there are batch of them. the flusher only has to be
+// woken for the first pending record, which sets its deadline
+void StreakJournal::record(RECORD type, int id, uint8_t attrs){
+    uint8_t bytes[JOURNALRECORD];
+    writeField(bytes, (uint32_t)(id - MINID) | (uint32_t)attrs << 17 | (uint32_t)type << 25);
+    m_crc = crc32(bytes, 4, m_crc);
+    writeField(bytes + 4, m_crc);
+    bool first;
+    bool full;
+    {
+        lock_guard<mutex> lock(m_lock);
+        first = m_pending.empty();
+        if (first){
+            m_oldest = chrono::steady_clock::now();
+        }
+        m_pending.insert(m_pending.end(), bytes, bytes + JOURNALRECORD);
+        m_appended++;
+        full = m_pending.size() >= (size_t)m_batch * JOURNALRECORD;
+    }
+    if (full){
+        flush();
+    }else if (first){
+        m_changed.notify_all();
+    }
+}
+
+// writes and syncs the pending records outside m_lock, so the streak can keep appending while the disk works. the
+// records go at m_end, which only moves once they are synced. if the write or the sync fails, whatever part of them
+// made it to the file is cut off again and they are put back in front of the records appended meanwhile, so the next
+// flush writes them over from the same offset, and the flusher waits another delay before it tries
+bool StreakJournal::flush(){
+    lock_guard<mutex> flushing(m_flushing);
+    vector<uint8_t> batch;
+    uint64_t upTo;
+    {
+        lock_guard<mutex> lock(m_lock);
+        batch.swap(m_pending);
+        upTo = m_appended;
+    }
+    if (batch.empty()){
+        return true;
+    }
+    size_t done = 0;
+    bool written = m_file >= 0;
+    while (written && done < batch.size()){
+        ssize_t bytes = pwrite(m_file, batch.data() + done, batch.size() - done, m_end + done);
+        written = bytes > 0;
+        done += written ? bytes : 0;
+    }
+    if (written && fdatasync(m_file) == 0){
+        lock_guard<mutex> lock(m_lock);
+        m_end += done;
+        m_durable = upTo;
+        m_syncs++;
+        return true;
+    }
+    // a tail that can not be cut off either is written over by the next flush, replay stops at it until then
+    if (m_file >= 0){
+        (void)ftruncate(m_file, m_end);
+    }
+    lock_guard<mutex> lock(m_lock);
+    batch.insert(batch.end(), m_pending.begin(), m_pending.end());
+    m_pending.swap(batch);
+    m_oldest = chrono::steady_clock::now();
+    return false;
+}
+
+// sleeps until there are pending records, then until the oldest of them has waited delay microseconds
+void StreakJournal::flushLoop(){
+    unique_lock<mutex> lock(m_lock);
+    while (!m_stopping){
+        if (m_pending.empty()){
+            m_changed.wait(lock);
+        }else if (chrono::steady_clock::now() < m_oldest + chrono::microseconds(m_delay)){
+            m_changed.wait_until(lock, m_oldest + chrono::microseconds(m_delay));
+        }else{
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+}
+
+// writes the header of an empty journal next to the journal, syncs it and renames it over the journal, then opens it
+// for appending. a crash leaves the old journal or the new one
+bool StreakJournal::start(uint32_t base){
+    uint8_t header[JOURNALHEADER];
+    writeField(header, JOURNALMAGIC);
+    writeField(header + 4, JOURNALVERSION);
+    writeField(header + 8, base);
+    writeField(header + 12, crc32(header, 12));
+    const string temporary = m_path + ".tmp";
+    int file = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0){
+        return false;
+    }
+    bool written = ::write(file, header, JOURNALHEADER) == JOURNALHEADER && fsync(file) == 0;
+    ::close(file);
+    if (!written || rename(temporary.c_str(), m_path.c_str()) != 0 || !syncDirectory(m_path)){
+        std::remove(temporary.c_str());
+        return false;
+    }
+    m_file = ::open(m_path.c_str(), O_WRONLY);
+    m_crc = readField(header + 12);
+    m_end = JOURNALHEADER;
+    return m_file >= 0;
+}
+
+// the crc32 a snapshot file ends with, 0 if it can not be read
+uint32_t StreakJournal::snapshotBase(const string &snapshot){
+    ifstream in(snapshot, ios::binary | ios::ate);
+    if (!in || in.tellg() < 4){
+        return 0;
+    }
+    uint8_t bytes[4];
+    in.seekg(-4, ios::end);
+    in.read(reinterpret_cast<char*>(bytes), 4);
+    return in ? readField(bytes) : 0;
+}
+
+// a rename is only durable once the directory that holds the file is synced
+bool StreakJournal::syncDirectory(const string &path){
+    size_t slash = path.rfind('/');
+    const string directory = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int file = ::open(directory.c_str(), O_RDONLY);
+    if (file < 0){
+        return false;
+    }
+    bool synced = fsync(file) == 0;
+    ::close(file);
+    return synced;
+}
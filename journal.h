@@ -0,0 +1,91 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+#include "streak.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// the journal file: a 16 byte header of magic "STRJ", u32 version, u32 base and u32 crc32 of the first 12 bytes, then
+// 8 byte records of a u32 (id - MINID) | attrs << 17 | RECORD << 25 and a u32 crc32 of those 4 bytes, continuing the
+// crc of the record before it (the first record continues the header's). a torn or stale tail breaks the chain, so
+// replay stops at the last record that was written whole. base is the crc32 at the end of the snapshot the journal
+// applies to, 0 if there is no snapshot, so a journal left over from before a compaction is never replayed twice
+const uint32_t JOURNALMAGIC = 0x4A525453;
+const uint32_t JOURNALVERSION = 1;
+const int JOURNALHEADER = 16;
+const int JOURNALRECORD = 8;
+// group commit defaults: the records appended since the last fsync are written and synced once there are this many,
+// or once the oldest of them has waited this long
+const int JOURNALBATCH = 64;
+const int JOURNALDELAY = 2000;//microseconds
+
+enum RECORD {INSERTRECORD, REMOVERECORD, STATERECORD, REMOVEDEADRECORD};
+
+// a write-ahead journal for a Streak. recover loads the last snapshot, replays the journal written since onto it and
+// attaches itself, and from then on every insert, remove, setState and removeDead that changes the streak is appended
+// as a record, and so is every tiger insertBatch, the set operations, split and join add or take away. the updates
+// that replace the whole tree (clear, build, assignment, load) have no record, the streak compacts the journal after
+// them instead, and so does a streak that is emptied or refilled by giving its tigers to another. records are kept in memory and made durable in groups: one write and
+// one fsync for up to batch records, and a flusher thread that syncs whatever has waited for delay microseconds, so an
+// update is durable within the delay without an fsync of its own. sync waits until everything appended so far is
+// durable. compact folds the journal into a new snapshot and starts an empty journal on it. one thread changes the
+// streak at a time, like any Streak, the flusher only touches the file. a streak that goes away before its journal
+// closes it
+class StreakJournal{
+public:
+    friend class Tester;
+    StreakJournal();
+    ~StreakJournal();// syncs and closes
+    StreakJournal(const StreakJournal&) = delete;
+    StreakJournal &operator=(const StreakJournal&) = delete;
+    // replaces the contents of streak with the snapshot (an empty streak if there is no snapshot file), replays the
+    // journal on it if it belongs to that snapshot, opens the journal for appending after the last whole record and
+    // attaches to streak. returns the # of records replayed, -1 if the snapshot can not be loaded or the journal can
+    // not be written
+    int recover(const string &snapshot, const string &journal, Streak &streak,
+                int batch = JOURNALBATCH, int delay = JOURNALDELAY);
+    // saves the streak as the new snapshot and starts an empty journal. returns false if it could not, the journal is
+    // closed and failed then
+    bool compact();
+    // returns once every record appended so far is on disk, or false if they could not be written or a compaction
+    // failed. records that fail to be written stay pending and are tried again by the next flush, a failed compaction
+    // is reported until the next recover
+    bool sync();
+    bool close();// syncs, detaches from the streak and stops the flusher, false if the last records could not be written
+    uint64_t appended() const;// returns the # of records appended since recover
+    uint64_t durable() const;// returns the # of those that are on disk
+    uint64_t syncs() const;// returns the # of fsyncs since recover
+    // called by the attached streak after an update changed it
+    void record(RECORD type, int id = MINID, uint8_t attrs = 0);
+private:
+    string m_snapshot;
+    string m_path;
+    Streak *m_streak;//the attached streak, nullptr while closed
+    int m_file;//the journal, -1 while closed
+    int m_batch;
+    int m_delay;
+    uint32_t m_crc;//the crc of the last record appended, or of the header
+    uint64_t m_end;//bytes of the journal written whole and synced, the next flush writes from here
+    vector<uint8_t> m_pending;//records appended but not written yet
+    uint64_t m_appended;
+    uint64_t m_durable;
+    uint64_t m_syncs;
+    chrono::steady_clock::time_point m_oldest;//when the first pending record was appended
+    bool m_stopping;
+    bool m_failed;//a compaction failed and closed the journal, until the next recover
+    mutable mutex m_lock;//guards every member the flusher reads
+    mutex m_flushing;//one flush at a time, taken before m_lock
+    condition_variable m_changed;//a record was appended, a flush finished or the flusher has to stop
+    thread m_flusher;
+
+    bool flush();
+    void flushLoop();
+    bool start(uint32_t base);
+    static uint32_t snapshotBase(const string &snapshot);
+    static bool syncDirectory(const string &path);
+};
+#endif
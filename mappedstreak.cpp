@@ -0,0 +1,152 @@
+#include "mappedstreak.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// what a closed streak points at, so every query works on it and finds nothing
+static const ImageHeader EMPTYHEADER = {};
+static const CompactTiger EMPTYNODES[1] = {};
+
+MappedStreak::MappedStreak(){
+    m_map = nullptr;
+    m_length = 0;
+    m_header = &EMPTYHEADER;
+    m_nodes = EMPTYNODES;
+}
+
+MappedStreak::~MappedStreak(){
+    close();
+}
+
+// the descriptor is not needed once the file is mapped, the mapping keeps the file open
+bool MappedStreak::open(const string &path){
+    close();
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0){
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 || (size_t)status.st_size < sizeof(ImageHeader)){
+        ::close(file);
+        return false;
+    }
+    void *map = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if (map == MAP_FAILED){
+        return false;
+    }
+    const ImageHeader *header = static_cast<const ImageHeader*>(map);
+    if (header->m_magic != IMAGEMAGIC || header->m_version != IMAGEVERSION || header->m_nodeSize != sizeof(CompactTiger)
+        || header->m_count > (uint32_t)(MAXID - MINID + 1) || header->m_root > header->m_count
+        || (size_t)status.st_size != sizeof(ImageHeader) + (header->m_count + 1) * sizeof(CompactTiger)){
+        munmap(map, status.st_size);
+        return false;
+    }
+    m_map = map;
+    m_length = status.st_size;
+    m_header = header;
+    m_nodes = reinterpret_cast<const CompactTiger*>(header + 1);
+    return true;
+}
+
+void MappedStreak::close(){
+    if (m_map != nullptr){
+        munmap(m_map, m_length);
+    }
+    m_map = nullptr;
+    m_length = 0;
+    m_header = &EMPTYHEADER;
+    m_nodes = EMPTYNODES;
+}
+
+bool MappedStreak::verify() const{
+    if (m_map == nullptr){
+        return false;
+    }
+    const uint8_t *nodes = reinterpret_cast<const uint8_t*>(m_nodes);
+    return crc32(nodes, (m_header->m_count + 1) * sizeof(CompactTiger)) == m_header->m_crc;
+}
+
+// the nodes are in id order already, so listing them is one scan
+void MappedStreak::listTigers() const{
+    forEachInRange(MINID, MAXID, [](const Tiger &tiger){
+        cout << tiger.getID() << ":" << tiger.getAgeStr() << ":" << tiger.getGenderStr() << ":" << tiger.getStateStr()
+        << endl;
+    });
+}
+
+bool MappedStreak::findTiger(int id) const{
+    return find(id) != NIL;
+}
+
+bool MappedStreak::getTiger(int id, Tiger &tiger) const{
+    uint32_t aTiger = find(id);
+    if (aTiger == NIL){
+        return false;
+    }
+    uint8_t attrs = m_nodes[aTiger].m_attrs;
+    tiger = Tiger(id, unpackAge(attrs), unpackGender(attrs), unpackState(attrs));
+    return true;
+}
+
+int MappedStreak::countTigerCubs() const{
+    return m_header->m_ages[CUB];
+}
+
+int MappedStreak::countBy(AGE age) const{
+    return m_header->m_ages[age];
+}
+
+int MappedStreak::countBy(GENDER gender) const{
+    return m_header->m_genders[gender];
+}
+
+int MappedStreak::countBy(STATE state) const{
+    return m_header->m_states[state];
+}
+
+int MappedStreak::size() const{
+    return m_header->m_count;
+}
+
+// node r + 1 holds the tiger of rank r
+int MappedStreak::rank(int id) const{
+    return lowerBound(id) - 1;
+}
+
+int MappedStreak::countInRange(int lo, int hi) const{
+    if (lo > hi){
+        return 0;
+    }
+    return (hi >= MAXID ? size() : rank(hi + 1)) - rank(lo);
+}
+
+// a plain descent that remembers the last node it went left at. ids are compared as ints, so ids outside
+// MINID..MAXID work too. a child past the last node or a path longer than any AVL tree has ends the descent, so a
+// damaged image can give a wrong bound but never one outside the nodes
+uint32_t MappedStreak::lowerBound(int id) const{
+    uint32_t bound = m_header->m_count + 1;
+    uint32_t aTiger = m_header->m_root;
+    for (int depth = 0; aTiger != NIL && aTiger <= m_header->m_count && depth < MAXDEPTH; depth++){
+        if (idOf(aTiger) >= id){
+            bound = aTiger;
+            aTiger = m_nodes[aTiger].m_left;
+        }else{
+            aTiger = m_nodes[aTiger].m_right;
+        }
+    }
+    return bound;
+}
+
+// a descent that stops at the id, NIL if it is not there. checked like lowerBound
+uint32_t MappedStreak::find(int id) const{
+    uint32_t aTiger = m_header->m_root;
+    for (int depth = 0; aTiger != NIL && aTiger <= m_header->m_count && depth < MAXDEPTH; depth++){
+        if (idOf(aTiger) == id){
+            return aTiger;
+        }
+        aTiger = id < idOf(aTiger) ? m_nodes[aTiger].m_left : m_nodes[aTiger].m_right;
+    }
+    return NIL;
+}
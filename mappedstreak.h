@@ -0,0 +1,76 @@
+#ifndef MAPPEDSTREAK_H
+#define MAPPEDSTREAK_H
+#include "streak.h"
+#include "compactstreak.h"
+#include <cstdint>
+#include <string>
+
+// the tree image written by Streak::saveImage: this header, then count + 1 CompactTigers with the sentinel first. the
+// nodes are in increasing id order, so the node of the tiger with rank r is r + 1, and the children are indices into
+// the same array. the image is in the byte order and CompactTiger layout of the machine that wrote it, a machine that
+// reads another magic or node size turns it away
+const uint32_t IMAGEMAGIC = 0x49525453;//"STRI" on a little endian machine
+const uint32_t IMAGEVERSION = 1;
+
+struct ImageHeader{
+    uint32_t m_magic;
+    uint32_t m_version;
+    uint32_t m_nodeSize;//sizeof(CompactTiger) of the writer
+    uint32_t m_count;//number of tigers
+    uint32_t m_root;//index of the root node, NIL if there are no tigers
+    uint32_t m_crc;//crc32 of the node array, checked by verify only
+    uint32_t m_ages[3];//number of tigers of each AGE
+    uint32_t m_genders[3];//number of tigers of each GENDER
+    uint32_t m_states[2];//number of tigers of each STATE
+    uint32_t m_reserved[2];//zero, pads the header to 64 bytes
+};
+static_assert(sizeof(ImageHeader) == 64, "the nodes of an image start 64 bytes in");
+
+// a read-only streak that runs its queries on a memory mapped tree image, with nothing read or built when it opens. the
+// mapping is shared, so every process that opens the same image uses the same pages of the page cache, and only the
+// pages a query touches are ever read from disk. open checks the header and the file size but not the nodes, verify
+// checks them against the checksum. the descents check every child index and their depth, so the queries on damaged
+// nodes give wrong answers but never read outside the map or loop
+class MappedStreak{
+public:
+    friend class Tester;
+    MappedStreak();
+    ~MappedStreak();
+    MappedStreak(const MappedStreak&) = delete;
+    MappedStreak &operator=(const MappedStreak&) = delete;
+    bool open(const string &path);// maps an image, returns false and stays closed if it is not one
+    void close();
+    bool verify() const;// reads every node and returns true if they match the checksum
+    void listTigers() const;
+    bool findTiger(int id) const;//returns true if the tiger is in the image
+    bool getTiger(int id, Tiger &tiger) const;//copies the tiger with this id into tiger, returns false if there is none
+    int countTigerCubs() const;// returns the # of cubs in the image, O(1)
+    int countBy(AGE age) const;
+    int countBy(GENDER gender) const;
+    int countBy(STATE state) const;
+    int size() const;
+    int rank(int id) const;// returns the # of tigers with an id smaller than id, O(log n)
+    int countInRange(int lo, int hi) const;// returns the # of tigers with lo <= id <= hi, O(log n)
+    // calls visitor(const Tiger&) on every tiger with lo <= id <= hi in increasing id order, one descent to the first
+    // one and a scan of the nodes after it, O(log n + k)
+    template <class Visitor>
+    void forEachInRange(int lo, int hi, Visitor &&visitor) const{
+        for (uint32_t aTiger = lowerBound(lo); aTiger <= m_header->m_count && idOf(aTiger) <= hi; aTiger++){
+            const Tiger tiger(idOf(aTiger), unpackAge(m_nodes[aTiger].m_attrs), unpackGender(m_nodes[aTiger].m_attrs),
+                              unpackState(m_nodes[aTiger].m_attrs));
+            visitor(tiger);
+        }
+    }
+private:
+    void *m_map;//the whole file, nullptr while closed
+    size_t m_length;//bytes mapped
+    const ImageHeader *m_header;//the start of the map, or an empty header while closed
+    const CompactTiger *m_nodes;//the node array, m_nodes[NIL] is the sentinel
+
+    int idOf(uint32_t aTiger) const{
+        return m_nodes[aTiger].m_key + MINID;
+    }
+    uint32_t find(int id) const;// the node of the id, NIL if there is none
+    uint32_t lowerBound(int id) const;// the node of the smallest id >= id, count + 1 if there is none
+};
+#endif
@@ -1,6 +1,30 @@
 #include "streak.h"
+#include "compactstreak.h"
+#include "densestreak.h"
+#include "streakview.h"
+#include "btreestreak.h"
+#include "taskpool.h"
+#include "concurrentstreak.h"
+#include "optimisticstreak.h"
+#include "shardedstreak.h"
+#include "mappedstreak.h"
+#include "journal.h"
+#include "feed.h"
 #include <vector>
 #include <random>
+#include <algorithm>
+#include <list>
+#include <thread>
+#include <chrono>
+#include <map>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
 enum RANDOM {UNIFORMINT, UNIFORMREAL, NORMAL};
 class Random {
 public:
@@ -91,12 +115,64 @@ public:
     void findDead(bool &, Tiger *aTiger); // checks to see if any dead are in the tree
     void countTigerCubs(); // tests if count tiger cubs works properly
     void countCubs(int &, Tiger *aTiger); // checks if count tiger cubs works properly
+    void countAll(int[8], Tiger *aTiger); // counts every AGE, GENDER and STATE value in a tree by traversal
+    void countsCheck(bool &, Tiger *aTiger); // checks if every node's subtree counts add up
     bool checkBSTProperty(Streak& aTree){
         return checkBSTProperty(aTree.m_root);
     }
     bool checkBSTProperty(Tiger *aTiger); // checks if bst properties are kept during insertion and removal
+    void randomOps(); // tests a long random mix of inserts and removes
+    void orderStatistics(); // tests size, rank and select
+    void rangeQueries(); // tests forEachInRange and countInRange
+    int heightCheck(bool &, Tiger *aTiger); // checks if stored heights match the real heights
     void insertTime(); // time complexity of insertion
     void removeTime(); // time complexity of remove
+    void removeVisits(); // node visits per remove compared to the tree height
+    void slabTime(); // insert and lookup time when clear() releases the slab or keeps it
+    void compactStreak(); // tests CompactStreak against Streak on the same operations
+    int compactCheck(bool &, const CompactStreak &, uint32_t aTiger); // checks order, heights and balance
+    void compactTime(); // node size and lookup time of CompactStreak against Streak
+    void denseStreak(); // tests DenseStreak against Streak on the same operations
+    void denseTime(); // lookup and update time of DenseStreak against Streak on a full roster
+    void streakView(); // tests a frozen StreakView against the streak it was made from
+    void viewTime(); // lookup time of a StreakView against the live Streak
+    void btreeStreak(); // tests BTreeStreak, and the backend picked at compile time, against Streak
+    template <class Backend>
+    bool sameBehaviour(); // runs inserts, removes, state changes and removeDead on a backend and on a Streak
+    int btreeCheck(bool &, const BTreeNode *node, int lo, int hi, bool root); // checks order, fill and leaf depth
+    void btreeTime(); // lookup and scan time of BTreeStreak against Streak
+    void avlTree(); // tests AvlTree with other keys, orders, augmentations and allocators against std::map
+    template <class Node>
+    int avlCheck(bool &, const Node *aNode); // checks heights, balance and subtree sizes, returns the height
+    void avlTime(); // insert, lookup and remove time of Streak against a plain AvlTree instantiation
+    void bulkBuild(); // tests building a streak from a batch against inserting the batch
+    void buildTime(); // time of building from a 1M record roster against inserting it
+    void batchInsert(); // tests insertBatch against inserting the batch one by one
+    bool sameStreak(Streak &, Streak &); // checks if two streaks hold the same tigers and are both valid AVL trees
+    void batchTime(); // time of insertBatch against an insert loop at several batch/streak ratios
+    void setOperations(); // tests unite, intersect, subtract, split and join against insert and remove loops
+    void parallelSetOperations(); // tests the parallel set operations against the sequential ones
+    void parallelTime(); // wall time of the parallel set operations from 1 thread to every core
+    void concurrentStreak(); // tests ConcurrentStreak against Streak, and readers running alongside a writer
+    int sharedCheck(bool &, const SharedTiger *aTiger, int lo, int hi); // checks order, heights, balance and counts
+    void epochReaders(); // tests EpochDomain with more readers inside than it has slots
+    void concurrentTime(); // lookup throughput of 1 to 64 readers next to a writer, against a Streak behind a mutex
+    void snapshots(); // tests Streak copies and ConcurrentStreak snapshots against the states they were taken from
+    bool sameSnapshot(const StreakSnapshot &, Streak &); // checks if a snapshot holds the tigers of a streak
+    void snapshotTime(); // time of a snapshot against a full copy, and of updates while snapshots are held
+    void optimisticStreak(); // tests OptimisticStreak alone against Streak and with several writers at once
+    int optimisticCheck(bool &, OptimisticTiger *node, OptimisticTiger *parent, int lo, int hi); // checks the tree
+    void optimisticTime(); // mixed workload throughput of the concurrent streaks from 1 to 8 threads
+    void shardedStreak(); // tests ShardedStreak against Streak, and writers on every shard at once
+    void shardedTime(); // mixed workload throughput of ShardedStreak with uniform and skewed ids from 1 to 8 threads
+    void saveLoad(); // tests save and load round trips, and that damaged or forged snapshot files are turned away
+    void saveTime(); // save and load time and file size of a binary snapshot against the listTigers text
+    void mappedStreak(); // tests MappedStreak on images of several streaks, from two maps and another process
+    bool sameImage(const MappedStreak &, Streak &); // checks if a mapped image holds the tigers of a streak
+    void mappedTime(); // warm start and lookup time of a mapped image against loading a snapshot
+    void journal(); // tests recovery from a snapshot and a journal, torn records, compaction and the flusher
+    void feedParsing(); // tests the roster feed parser on line endings, long lines and every rejection reason
+    void journalTime(); // update throughput with a journal attached, from one fsync per update to one per 512
 };
 
 int main(){
@@ -110,8 +186,46 @@ int main(){
     tester.removeLarge();
     tester.removeDead();
     tester.countTigerCubs();
+    tester.randomOps();
+    tester.orderStatistics();
+    tester.rangeQueries();
+    tester.compactStreak();
+    tester.denseStreak();
+    tester.streakView();
+    tester.btreeStreak();
+    tester.avlTree();
+    tester.bulkBuild();
+    tester.batchInsert();
+    tester.setOperations();
+    tester.parallelSetOperations();
+    tester.concurrentStreak();
+    tester.epochReaders();
+    tester.snapshots();
+    tester.optimisticStreak();
+    tester.shardedStreak();
+    tester.saveLoad();
+    tester.mappedStreak();
+    tester.journal();
+    tester.feedParsing();
     tester.insertTime();
     tester.removeTime();
+    tester.removeVisits();
+    tester.slabTime();
+    tester.compactTime();
+    tester.denseTime();
+    tester.viewTime();
+    tester.btreeTime();
+    tester.avlTime();
+    tester.buildTime();
+    tester.batchTime();
+    tester.parallelTime();
+    tester.concurrentTime();
+    tester.snapshotTime();
+    tester.optimisticTime();
+    tester.shardedTime();
+    tester.saveTime();
+    tester.mappedTime();
+    tester.journalTime();
 
     return 0;
 }
@@ -237,9 +351,10 @@ void Tester::insert() {
 
     // creating fifth tree
     Streak streak5;
-    // inserting error values
-    streak5.insert(999);
-    streak5.insert(563782939);
+    // inserting error values, insert reports them as out of range
+    bool results = true;
+    if (streak5.insert(999) != OUTOFRANGE) results = false;
+    if (streak5.insert(563782939) != OUTOFRANGE) results = false;
     streakSize = 6;
     counter = 63000;
 
@@ -249,11 +364,11 @@ void Tester::insert() {
         Tiger tiger(id,
                     static_cast<AGE>(ageGen.getRandNum()),
                     static_cast<GENDER>(genderGen.getRandNum()));
-        streak5.insert(tiger);
+        if (streak5.insert(tiger) != INSERTED) results = false;
     }
 
-    // inserting duplicate
-    streak5.insert(63000);
+    // inserting duplicate, insert reports it without a separate findTiger
+    if (streak5.insert(63000) != DUPLICATE) results = false;
 
     // checking if tree is imbalanced, if the BST property is kept, and if inserted tree correctly as well as duplicate
     // values
@@ -273,7 +388,7 @@ void Tester::insert() {
     duplicate(count, 58000, streak5.m_root);
 
     if (!streak5.findTiger(999) && !streak5.findTiger(563782939) && insert && count < 2
-    && !imbalanced && checkBSTProperty(streak5)){
+    && results && !imbalanced && checkBSTProperty(streak5)){
         cout << "INSERT ERROR PASSED" << endl;
     }
 }
@@ -618,15 +733,16 @@ void Tester::removeRebalance() {
     }
 }
 
-// tests if tree is balanced after a large number of insertions
+// tests if tree is balanced after a large number of insertions, 1k/10k/100k insert workloads
 void Tester::insertLarge() {
     // creating tree
     Random idGen(MINID,MAXID);
     Random ageGen(0,2);
     Random genderGen(0,2);
-    {
+    int sizes[] = {1000, 10000, 100000};
+    bool passed = true;
+    for (int streakSize : sizes){
         Streak streak;
-        int streakSize = 1000;
         int ID = 0;
 
         // inserting nodes
@@ -643,12 +759,15 @@ void Tester::insertLarge() {
         imbalanceCheck(imbalanced, streak.m_root);
         bool insert = true;
         insertTest(insert, streak.m_root);
-        if (insert && !imbalanced && checkBSTProperty(streak)){
-            cout << "INSERT LARGE PASSED" << endl;
-        }else{
-            cout << "INSERT LARGE FAILED" << endl;
+        if (!insert || imbalanced || !checkBSTProperty(streak)){
+            passed = false;
         }
     }
+    if (passed){
+        cout << "INSERT LARGE PASSED" << endl;
+    }else{
+        cout << "INSERT LARGE FAILED" << endl;
+    }
 }
 
 // checks if tree is balanced after a large number of removals
@@ -700,6 +819,7 @@ void Tester::removeDead() {
     Streak streak;
     int streakSize = 20;
     int counter = 58000;
+    int deadCount = 0;
 
     // inserts nodes
     for (int i = 0; i < streakSize; i++){
@@ -708,24 +828,49 @@ void Tester::removeDead() {
                     static_cast<AGE>(ageGen.getRandNum()),
                     static_cast<GENDER>(genderGen.getRandNum()),
                     static_cast<STATE>(stateGen.getRandNum()));
+        if (tiger.getState() == DEAD) deadCount++;
         streak.insert(tiger);
     }
 
-    // removes all dead tigers and checks if they are all removed. then, checks balance of the tree, insertion,
-    // and the BST properties of the tree
-    streak.removeDead();
+    // removes all dead tigers and checks if they are all removed and counted. then, checks balance of the tree,
+    // insertion, and the BST properties of the tree
+    int removed = streak.removeDead();
     bool dead = false;
     findDead(dead, streak.m_root);
     bool imbalanced = false;
     imbalanceCheck(imbalanced, streak.m_root);
     bool insert = true;
     insertTest(insert, streak.m_root);
-    if (!dead && insert && !imbalanced && checkBSTProperty(streak)){
+    if (!dead && removed == deadCount && insert && !imbalanced && checkBSTProperty(streak)){
         cout << "REMOVE DEAD PASSED" << endl;
     }else{
         cout << "REMOVE DEAD FAILED" << endl;
     }
 
+    // large case, about 30% of 80000 tigers are dead. the rebuilt tree has to keep correct heights and stay usable
+    Random largeStateGen(0, 9);
+    Streak streak2;
+    deadCount = 0;
+    for (int i = 0; i < 80000; i++){
+        Tiger tiger(MINID + i, CUB, UNKNOWN, largeStateGen.getRandNum() < 3 ? DEAD : ALIVE);
+        if (tiger.getState() == DEAD) deadCount++;
+        streak2.insert(tiger);
+    }
+    removed = streak2.removeDead();
+    dead = false;
+    findDead(dead, streak2.m_root);
+    bool heights = true;
+    heightCheck(heights, streak2.m_root);
+    imbalanced = false;
+    imbalanceCheck(imbalanced, streak2.m_root);
+    // the tree still takes inserts and removes after the rebuild
+    streak2.insert(Tiger(MINID + 1));
+    bool reuse = streak2.remove(MINID + 1) && !streak2.findTiger(MINID + 1);
+    if (!dead && removed == deadCount && heights && reuse && !imbalanced && checkBSTProperty(streak2)){
+        cout << "REMOVE DEAD LARGE PASSED" << endl;
+    }else{
+        cout << "REMOVE DEAD LARGE FAILED" << endl;
+    }
 }
 
 
@@ -782,6 +927,109 @@ void Tester::countTigerCubs() {
     }else{
         cout << "COUNT TIGER CUBS FAILED" << endl;
     }
+
+    // changes some states and removes some tigers, then checks countBy for every value against a traversal
+    for (int i = 0; i < streakSize; i++){
+        id = idGen.getRandNum();
+        streak.setState(id, static_cast<STATE>(stateGen.getRandNum()));
+        streak.remove(idGen.getRandNum());
+    }
+    streak.setState(streak.m_root->getID(), DEAD);
+    streak.removeDead();
+    int totals[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    countAll(totals, streak.m_root);
+    int counted[8] = {streak.countBy(CUB), streak.countBy(YOUNG), streak.countBy(OLD),
+                      streak.countBy(MALE), streak.countBy(FEMALE), streak.countBy(UNKNOWN),
+                      streak.countBy(ALIVE), streak.countBy(DEAD)};
+    bool counts = true;
+    countsCheck(counts, streak.m_root);
+    for (int i = 0; i < 8; i++){
+        if (totals[i] != counted[i]) counts = false;
+    }
+    if (counts && streak.countTigerCubs() == totals[CUB]){
+        cout << "COUNT BY PASSED" << endl;
+    }else{
+        cout << "COUNT BY FAILED" << endl;
+    }
+}
+
+// counts ages in totals[0..2], genders in totals[3..5] and states in totals[6..7]
+void Tester::countAll(int totals[8], Tiger *aTiger) {
+    if (aTiger != nullptr){
+        countAll(totals, aTiger->getLeft());
+        totals[aTiger->getAge()]++;
+        totals[3 + aTiger->getGender()]++;
+        totals[6 + aTiger->getState()]++;
+        countAll(totals, aTiger->getRight());
+    }
+}
+
+// checks that every node counts itself plus what its children count
+void Tester::countsCheck(bool &counts, Tiger *aTiger) {
+    if (aTiger != nullptr){
+        countsCheck(counts, aTiger->getLeft());
+        countsCheck(counts, aTiger->getRight());
+        int expected[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        expected[aTiger->getAge()]++;
+        expected[3 + aTiger->getGender()]++;
+        expected[6 + aTiger->getState()]++;
+        Tiger *children[2] = {aTiger->getLeft(), aTiger->getRight()};
+        for (Tiger *child : children){
+            if (child != nullptr){
+                for (int i = 0; i < 3; i++){
+                    expected[i] += child->m_ages[i];
+                    expected[3 + i] += child->m_genders[i];
+                }
+                expected[6] += child->m_states[ALIVE];
+                expected[7] += child->m_states[DEAD];
+            }
+        }
+        for (int i = 0; i < 3; i++){
+            if (aTiger->m_ages[i] != expected[i] || aTiger->m_genders[i] != expected[3 + i]) counts = false;
+        }
+        if (aTiger->m_states[ALIVE] != expected[6] || aTiger->m_states[DEAD] != expected[7]) counts = false;
+        // every tiger has exactly one age, so the ages add up to the subtree size
+        if (aTiger->m_size != expected[0] + expected[1] + expected[2]) counts = false;
+    }
+}
+
+// tests size, rank and select against a sorted list of the ids after inserts and removes
+void Tester::orderStatistics() {
+    Random idGen(MINID,MAXID);
+    Streak streak;
+    vector<int> ids;
+    for (int i = 0; i < 2000; i++){
+        int id = idGen.getRandNum();
+        if (streak.insert(Tiger(id)) == INSERTED) ids.push_back(id);
+    }
+    // removes every third id
+    vector<int> kept;
+    for (unsigned int i = 0; i < ids.size(); i++){
+        if (i % 3 == 0){
+            streak.remove(ids[i]);
+        }else{
+            kept.push_back(ids[i]);
+        }
+    }
+    sort(kept.begin(), kept.end());
+
+    bool order = streak.size() == (int)kept.size();
+    for (unsigned int i = 0; i < kept.size(); i++){
+        if (streak.select(i) != kept[i]) order = false;
+        if (streak.rank(kept[i]) != (int)i) order = false;
+        // an id that is not in the streak ranks after every smaller id
+        if (streak.rank(kept[i] + 1) != (int)i + 1 && (i + 1 == kept.size() || kept[i + 1] != kept[i] + 1)) order = false;
+    }
+    // edge cases, out of range k and ids below/above everything
+    if (streak.select(-1) != DEFAULT_ID || streak.select(kept.size()) != DEFAULT_ID) order = false;
+    if (streak.rank(MINID - 1) != 0 || streak.rank(MAXID + 1) != (int)kept.size()) order = false;
+    Streak empty;
+    if (empty.size() != 0 || empty.rank(MINID) != 0 || empty.select(0) != DEFAULT_ID) order = false;
+    if (order){
+        cout << "ORDER STATISTICS PASSED" << endl;
+    }else{
+        cout << "ORDER STATISTICS FAILED" << endl;
+    }
 }
 
 
@@ -806,9 +1054,11 @@ bool Tester::checkBSTProperty(Tiger* aNode){
     // this function performs pre-order traversal
     // first we visit the node
     // protection for empty root
-    if (aNode == nullptr ||
-        // leaf node
-        ((aNode->getLeft() == nullptr) && (aNode->getRight() == nullptr)))
+    if (aNode == nullptr){
+        return true;
+    }
+    // leaf node
+    if ((aNode->getLeft() == nullptr) && (aNode->getRight() == nullptr))
         result = true;
         // the case of a node with only right child
     else if (aNode->getLeft() == nullptr && aNode->getRight() != nullptr){
@@ -836,142 +1086,1837 @@ bool Tester::checkBSTProperty(Tiger* aNode){
     return result;
 }
 
-// checks time complexity for insertion time (if it is accepted)
-void Tester::insertTime() {
-    // creating a tree of 1000 nodes and getting the start time and end time of insertion
+// tests a long random mix of inserts and removes, retrace stops early so the stored heights are checked too
+void Tester::randomOps() {
+    Random idGen(MINID, MINID + 3000);
+    Random opGen(0, 3);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
     Streak streak;
-
-    auto startTime = clock();
-    for (int i = 0; i < 1000; i++) {
-        Tiger tiger(MINID+i);
-        streak.insert(tiger);
+    bool results = true;
+    for (int i = 0; i < 20000; i++){
+        int id = idGen.getRandNum();
+        bool found = streak.findTiger(id);
+        int op = opGen.getRandNum();
+        // half inserts, a quarter removes and a quarter state changes
+        if (op < 2){
+            Tiger tiger(id,
+                        static_cast<AGE>(ageGen.getRandNum()),
+                        static_cast<GENDER>(genderGen.getRandNum()));
+            RESULT result = streak.insert(tiger);
+            if (result != (found ? DUPLICATE : INSERTED)) results = false;
+        }else if (op == 2){
+            if (streak.remove(id) != found) results = false;
+            if (streak.findTiger(id)) results = false;
+        }else{
+            if (streak.setState(id, static_cast<STATE>(i % 2)) != found) results = false;
+        }
     }
-    // getting T1 and clearing the tree
-    auto endTime = clock();
-    double T1 = endTime - startTime;
-    streak.clear();
 
-    // getting T2, 2000 nodes
-    startTime = clock();
-    for (int i = 0; i < 2000; i++) {
-        Tiger tiger(MINID+i);
-        streak.insert(tiger);
+    // checks if tree is balanced/heights are correct/BST properties are kept
+    bool imbalanced = false;
+    imbalanceCheck(imbalanced, streak.m_root);
+    bool heights = true;
+    heightCheck(heights, streak.m_root);
+    bool counts = true;
+    countsCheck(counts, streak.m_root);
+    if (results && heights && counts && !imbalanced && checkBSTProperty(streak)){
+        cout << "RANDOM OPS PASSED" << endl;
+    }else{
+        cout << "RANDOM OPS FAILED" << endl;
     }
-    endTime = clock();
-    double T2 = endTime - startTime;
-    streak.clear();
+}
 
-    // T3, 3000 nodes
-    startTime = clock();
-    for (int i = 0; i < 3000; i++) {
-        Tiger tiger(MINID+i);
-        streak.insert(tiger);
+// returns the real height of a subtree and clears the flag if a stored height does not match it
+int Tester::heightCheck(bool &heights, Tiger *aTiger) {
+    if (aTiger == nullptr){
+        return -1;
     }
-    endTime = clock();
-    double T3 = endTime - startTime;
-    streak.clear();
-
-    // calculating the ratio
-    double ratio = 1000*log2(1000);
-
-    // calculating expected ratio of current insertions
-    int n = 2000;
-    double expectedRatio = (n*log2(n))/ratio;
-
-    // calculating my ratio and printing values
-    double myRatio = T2/T1;
-    cout << "This is the expected ratio for insert (n=2000): " << expectedRatio << endl;
-    cout << "T2: " << T2 << ". T1: " << T1  << "." << endl;
-    cout << "This is my ratio: " << myRatio << endl;
+    int left = heightCheck(heights, aTiger->getLeft());
+    int right = heightCheck(heights, aTiger->getRight());
+    int height = (left > right ? left : right) + 1;
+    if (aTiger->getHeight() != height){
+        heights = false;
+    }
+    return height;
+}
 
-    // checking if my ratio is acceptable
-    if ((expectedRatio-0.4) < (myRatio) && (myRatio) < (expectedRatio+0.4)){
-        cout << "acceptable ratio" << endl;
+// tests forEachInRange and countInRange against a sorted list of the ids
+void Tester::rangeQueries() {
+    Random idGen(MINID,MAXID);
+    Random ageGen(0,2);
+    Streak streak;
+    vector<int> ids;
+    for (int i = 0; i < 3000; i++){
+        int id = idGen.getRandNum();
+        if (streak.insert(Tiger(id, static_cast<AGE>(ageGen.getRandNum()))) == INSERTED) ids.push_back(id);
+    }
+    sort(ids.begin(), ids.end());
+
+    bool ranges = true;
+    for (int i = 0; i < 200; i++){
+        int lo = idGen.getRandNum();
+        int hi = lo + i * 50;
+        // the ids a correct range query has to visit, in order
+        vector<int> expected;
+        for (int id : ids){
+            if (id >= lo && id <= hi) expected.push_back(id);
+        }
+        vector<int> visited;
+        int cubs = 0;
+        streak.forEachInRange(lo, hi, [&](const Tiger &tiger){
+            visited.push_back(tiger.getID());
+            if (tiger.getAge() == CUB) cubs++;
+        });
+        if (visited != expected || streak.countInRange(lo, hi) != (int)expected.size()) ranges = false;
+        if (cubs > (int)expected.size()) ranges = false;
+    }
+    // edge cases, the whole id space, an empty range and a single id
+    int count = 0;
+    streak.forEachInRange(MINID, MAXID, [&count](const Tiger &){ count++; });
+    if (count != (int)ids.size() || streak.countInRange(MINID, MAXID) != (int)ids.size()) ranges = false;
+    if (streak.countInRange(MAXID, MINID) != 0) ranges = false;
+    if (streak.countInRange(INT_MIN, INT_MAX) != (int)ids.size() || streak.countInRange(MAXID + 1, INT_MAX) != 0) ranges = false;
+    if (streak.countInRange(ids[10], ids[10]) != 1) ranges = false;
+    if (ranges){
+        cout << "RANGE QUERIES PASSED" << endl;
+    }else{
+        cout << "RANGE QUERIES FAILED" << endl;
     }
+}
 
-    // calculating expected ratio of current insertions
-    n = 3000;
-    expectedRatio = (n*log2(n))/ratio;
+// runs the same random inserts, removes and state changes on a Streak and a CompactStreak and compares them
+void Tester::compactStreak() {
+    Random idGen(MINID, MINID + 5000);
+    Random opGen(0, 3);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    Streak streak;
+    CompactStreak compact;
+    bool same = compact.insert(Tiger(MINID - 1)) == OUTOFRANGE && !compact.remove(MAXID + 1);
+    for (int i = 0; i < 20000; i++){
+        int id = idGen.getRandNum();
+        int op = opGen.getRandNum();
+        if (op < 2){
+            Tiger tiger(id,
+                        static_cast<AGE>(ageGen.getRandNum()),
+                        static_cast<GENDER>(genderGen.getRandNum()));
+            if (streak.insert(tiger) != compact.insert(tiger)) same = false;
+        }else if (op == 2){
+            if (streak.remove(id) != compact.remove(id)) same = false;
+        }else{
+            if (streak.setState(id, static_cast<STATE>(i % 2)) != compact.setState(id, static_cast<STATE>(i % 2))) same = false;
+        }
+    }
+    if (streak.removeDead() != compact.removeDead()) same = false;
+
+    // every id is found by both or neither, with the same attributes
+    for (int id = MINID; id <= MINID + 5000; id++){
+        Tiger tiger;
+        if (streak.findTiger(id) != compact.findTiger(id)) same = false;
+        if (compact.getTiger(id, tiger) && (tiger.getID() != id || tiger.getAge() != streak.getTiger(id)->getAge()
+            || tiger.getGender() != streak.getTiger(id)->getGender() || tiger.getState() != ALIVE)) same = false;
+    }
+    if (streak.size() != compact.size() || streak.countTigerCubs() != compact.countTigerCubs()) same = false;
+    for (int g = MALE; g <= UNKNOWN; g++){
+        if (streak.countBy(static_cast<GENDER>(g)) != compact.countBy(static_cast<GENDER>(g))) same = false;
+    }
+    bool valid = true;
+    compactCheck(valid, compact, compact.m_root);
+    if (same && valid && sizeof(CompactTiger) <= 16){
+        cout << "COMPACT STREAK PASSED" << endl;
+    }else{
+        cout << "COMPACT STREAK FAILED" << endl;
+    }
+}
 
-    // calculating my ratio and printing values
-    myRatio = T3/T1;
-    cout << "This is the expected ratio for insert (n=3000): " << expectedRatio << endl;
-    cout << "T3: " << T3 << ". T1: " << "." << T1 << endl;
-    cout << "This is my ratio: " << myRatio << endl;
+// random inserts, removes and state changes on a Streak and a DenseStreak over the whole id range, then compares
+// every id, the counts and range counts
+void Tester::denseStreak() {
+    Random idGen(MINID - 10, MAXID + 10);
+    Random opGen(0, 3);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    Streak streak;
+    DenseStreak dense;
+    bool same = dense.insert(Tiger(MINID - 1)) == OUTOFRANGE && !dense.remove(MAXID + 1) && !dense.findTiger(MINID);
+    for (int i = 0; i < 200000; i++){
+        int id = idGen.getRandNum();
+        int op = opGen.getRandNum();
+        if (op < 2){
+            Tiger tiger(id,
+                        static_cast<AGE>(ageGen.getRandNum()),
+                        static_cast<GENDER>(genderGen.getRandNum()));
+            if (streak.insert(tiger) != dense.insert(tiger)) same = false;
+        }else if (op == 2){
+            if (streak.remove(id) != dense.remove(id)) same = false;
+        }else{
+            if (streak.setState(id, static_cast<STATE>(i % 2)) != dense.setState(id, static_cast<STATE>(i % 2))) same = false;
+        }
+    }
+    int ranges[][2] = {{MINID - 5, MAXID + 5}, {MINID, MINID}, {MAXID, MAXID}, {MINID + 63, MINID + 64},
+                       {MINID + 100, MINID + 90}, {20000, 71234}};
+    for (auto &range : ranges){
+        if (streak.countInRange(range[0], range[1]) != dense.countInRange(range[0], range[1])) same = false;
+    }
+    if (streak.countBy(DEAD) != dense.countBy(DEAD)) same = false;
+    if (streak.removeDead() != dense.removeDead()) same = false;
+
+    // every id is found by both or neither, with the same attributes
+    for (int id = MINID; id <= MAXID; id++){
+        Tiger tiger;
+        if (streak.findTiger(id) != dense.findTiger(id)) same = false;
+        if (dense.getTiger(id, tiger) && (tiger.getID() != id || tiger.getAge() != streak.getTiger(id)->getAge()
+            || tiger.getGender() != streak.getTiger(id)->getGender() || tiger.getState() != ALIVE)) same = false;
+    }
+    if (streak.size() != dense.size() || streak.countTigerCubs() != dense.countTigerCubs()) same = false;
+    for (int g = MALE; g <= UNKNOWN; g++){
+        if (streak.countBy(static_cast<GENDER>(g)) != dense.countBy(static_cast<GENDER>(g))) same = false;
+    }
+    dense.clear();
+    if (dense.size() != 0 || dense.findTiger(streak.select(0)) || dense.insert(Tiger(MAXID)) != INSERTED) same = false;
+    if (same){
+        cout << "DENSE STREAK PASSED" << endl;
+    }else{
+        cout << "DENSE STREAK FAILED" << endl;
+    }
+}
 
-    // checking if my ratio is acceptable
-    if ((expectedRatio-0.4) < (myRatio) && (myRatio) < (expectedRatio+0.4)){
-        cout << "acceptable ratio" << endl;
+// freezes streaks of several sizes, including empty and 2^k - 1 (a full last level), and compares every lookup and
+// range count of the view with the streak. the view keeps its tigers when the streak changes afterwards
+void Tester::streakView() {
+    Random idGen(MINID, MINID + 4000);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    Random stateGen(0,1);
+    bool same = true;
+    int sizes[] = {0, 1, 2, 7, 8, 100, 1023, 3000};
+    for (int n : sizes){
+        Streak streak;
+        while (streak.size() < n){
+            streak.insert(Tiger(idGen.getRandNum(),
+                                static_cast<AGE>(ageGen.getRandNum()),
+                                static_cast<GENDER>(genderGen.getRandNum()),
+                                static_cast<STATE>(stateGen.getRandNum())));
+        }
+        StreakView view = streak.freezeView();
+        if (view.size() != streak.size()) same = false;
+        for (int id = MINID - 2; id <= MINID + 4002; id++){
+            Tiger tiger;
+            if (view.findTiger(id) != streak.findTiger(id)) same = false;
+            if (view.getTiger(id, tiger) && (tiger.getID() != id || tiger.getAge() != streak.getTiger(id)->getAge()
+                || tiger.getGender() != streak.getTiger(id)->getGender()
+                || tiger.getState() != streak.getTiger(id)->getState())) same = false;
+            int hi = id + id % 97;
+            if (view.countInRange(id, hi) != streak.countInRange(id, hi)) same = false;
+        }
+        if (view.countInRange(MINID, MAXID) != n || view.countInRange(MINID + 5, MINID + 4) != 0) same = false;
+        if (view.countInRange(INT_MIN, INT_MAX) != n || view.countInRange(MAXID + 1, INT_MAX) != 0) same = false;
+        if (view.findTiger(DEFAULT_ID) || view.findTiger(MAXID + 1)) same = false;
+        if (n > 0){
+            int id = streak.select(0);
+            streak.remove(id);
+            if (!view.findTiger(id) || view.size() != n) same = false;
+        }
+    }
+    if (same){
+        cout << "STREAK VIEW PASSED" << endl;
+    }else{
+        cout << "STREAK VIEW FAILED" << endl;
     }
 }
 
+// the insert, remove, removeDead and countTigerCubs checks through the public API only, on BTreeStreak and on
+// whichever backend STREAK_BTREE picked. the B-tree is also checked node by node after every phase
+void Tester::btreeStreak() {
+    bool same = sameBehaviour<BTreeStreak>() && sameBehaviour<StreakBackend>();
+    BTreeStreak btree;
+    bool valid = btree.insert(Tiger(MINID - 1)) == OUTOFRANGE && !btree.remove(MAXID + 1) && !btree.findTiger(MINID);
+    Random idGen(MINID, MAXID);
+    Random stateGen(0, 3);
+    for (int i = 0; i < 50000; i++){
+        btree.insert(Tiger(idGen.getRandNum()));
+    }
+    // a duplicate is found on the way down, after the full nodes above it were split
+    int tigers = btree.size();
+    for (int id = MINID; id <= MAXID; id += 7){
+        if (btree.findTiger(id) && btree.insert(Tiger(id, OLD)) != DUPLICATE) valid = false;
+    }
+    if (btree.size() != tigers || btree.countBy(OLD) != 0) valid = false;
+    btreeCheck(valid, btree.m_root, MINID - 1, MAXID + 1, true);
+    for (int i = 0; i < 60000; i++){
+        int id = idGen.getRandNum();
+        if (stateGen.getRandNum() == 0) btree.setState(id, DEAD);
+        else btree.remove(id);
+    }
+    btreeCheck(valid, btree.m_root, MINID - 1, MAXID + 1, true);
+    btree.removeDead();
+    btreeCheck(valid, btree.m_root, MINID - 1, MAXID + 1, true);
+    for (int id = MINID; id <= MAXID; id++){
+        btree.remove(id);
+    }
+    if (btree.m_root != nullptr || btree.size() != 0) valid = false;
+    if (same && valid){
+        cout << "BTREE STREAK PASSED" << endl;
+    }else{
+        cout << "BTREE STREAK FAILED" << endl;
+    }
+}
 
-// checking time complexity of remove
-void Tester::removeTime() {
-    // creating a tree
+template <class Backend>
+bool Tester::sameBehaviour() {
+    Random idGen(MINID - 10, MINID + 3000);
+    Random opGen(0, 4);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    bool same = true;
     Streak streak;
-
-    // getting T1, removal of 1000 nodes
-    for (int i = 0; i < 1000; i++) {
-        Tiger tiger(MINID + i);
-        streak.insert(tiger);
+    Backend backend;
+    for (int i = 0; i < 30000; i++){
+        int id = idGen.getRandNum();
+        int op = opGen.getRandNum();
+        if (op < 2){
+            Tiger tiger(id, static_cast<AGE>(ageGen.getRandNum()), static_cast<GENDER>(genderGen.getRandNum()));
+            if (streak.insert(tiger) != backend.insert(tiger)) same = false;
+        }else if (op < 4){
+            if (streak.remove(id) != backend.remove(id)) same = false;
+        }else{
+            if (streak.setState(id, static_cast<STATE>(i % 2)) != backend.setState(id, static_cast<STATE>(i % 2))) same = false;
+        }
+        if (i % 10000 == 9999 && streak.removeDead() != backend.removeDead()) same = false;
     }
-    auto startTime = clock();
-    for (int i = 0; i < 1000; i++) {
-        streak.remove(MINID + i);
+    vector<uint32_t> expected;
+    vector<uint32_t> actual;
+    streak.forEachInRange(MINID, MAXID, [&expected](const Tiger &tiger){expected.push_back(Streak::pack(tiger));});
+    backend.forEachInRange(MINID, MAXID, [&actual](const Tiger &tiger){actual.push_back(Streak::pack(tiger));});
+    if (expected != actual || streak.size() != backend.size()) same = false;
+    if (streak.countTigerCubs() != backend.countTigerCubs() || streak.countBy(DEAD) != backend.countBy(DEAD)) same = false;
+    for (int g = MALE; g <= UNKNOWN; g++){
+        if (streak.countBy(static_cast<GENDER>(g)) != backend.countBy(static_cast<GENDER>(g))) same = false;
     }
-    auto endTime = clock();
-    double T1 = endTime - startTime;
-    streak.clear();
+    return same;
+}
 
-    // getting T2, removal of 2000 nodes
-    for (int i = 0; i < 2000; i++) {
-        Tiger tiger(MINID + i);
-        streak.insert(tiger);
+// returns the depth of the leaves below a B-tree node, clears the flag if ids are out of order or outside (lo, hi), a
+// node other than the root holds too few tigers, the padding is wrong or two leaves are at different depths
+int Tester::btreeCheck(bool &valid, const BTreeNode *node, int lo, int hi, bool root) {
+    if (node == nullptr){
+        return 0;
     }
-    startTime = clock();
-    for (int i = 0; i < 2000; i++) {
-        streak.remove(MINID + i);
+    if (node->m_count >= BTREEKEYS || (!root && node->m_count < BTREEMIN) || (!node->m_leaf && node->m_count == 0)){
+        valid = false;
     }
-    endTime = clock();
-    double T2 = endTime - startTime;
-    streak.clear();
+    for (int i = 0; i < BTREEKEYS; i++){
+        if (i >= node->m_count && node->m_ids[i] != INT_MAX) valid = false;
+    }
+    for (int i = 0; i < node->m_count; i++){
+        int below = i == 0 ? lo : node->m_ids[i - 1];
+        if (node->m_ids[i] <= below || node->m_ids[i] >= hi) valid = false;
+    }
+    if (node->m_leaf){
+        return 1;
+    }
+    int depth = -1;
+    for (int i = 0; i <= node->m_count; i++){
+        int below = i == 0 ? lo : node->m_ids[i - 1];
+        int above = i == node->m_count ? hi : node->m_ids[i];
+        int childDepth = btreeCheck(valid, node->m_children[i], below, above, false);
+        if (depth != -1 && childDepth != depth) valid = false;
+        depth = childDepth;
+    }
+    return depth + 1;
+}
 
-    // getting T3, removal of 3000 nodes
-    for (int i = 0; i < 3000; i++) {
-        Tiger tiger(MINID + i);
-        streak.insert(tiger);
+// an allocator that counts the nodes it hands out, to check that AvlTree allocates through it and frees everything
+template <class T>
+struct CountingAllocator{
+    typedef T value_type;
+    int *m_live;
+    explicit CountingAllocator(int *live) : m_live(live){}
+    template <class U>
+    CountingAllocator(const CountingAllocator<U> &other) : m_live(other.m_live){}
+    T *allocate(size_t n){
+        *m_live += n;
+        return allocator<T>().allocate(n);
     }
-    startTime = clock();
-    for (int i = 0; i < 3000; i++) {
-        streak.remove(MINID + i);
+    void deallocate(T *p, size_t n){
+        *m_live -= n;
+        allocator<T>().deallocate(p, n);
     }
-    endTime = clock();
-    double T3 = endTime - startTime;
-    streak.clear();
+};
 
-    // getting ratio and expected ratio for n = 2000
-    double ratio = 1000 * log2(1000);
+// random inserts and removes on an AvlTree in reverse order with subtree sizes and a counting allocator, compared
+// with a std::map, and a string keyed tree
+void Tester::avlTree() {
+    Random keyGen(0, 3000);
+    Random opGen(0, 2);
+    bool same = true;
+    int live = 0;
+    {
+        typedef AvlTree<int, int, greater<int>, SizeAugment, CountingAllocator<int>> Tree;
+        Tree tree{greater<int>(), CountingAllocator<int>(&live)};
+        map<int, int, greater<int>> expected;
+        for (int i = 0; i < 40000; i++){
+            int key = keyGen.getRandNum();
+            if (opGen.getRandNum() < 2){
+                if (tree.insert(key, i) != expected.insert({key, i}).second) same = false;
+            }else{
+                if (tree.remove(key) != (expected.erase(key) == 1)) same = false;
+            }
+        }
+        bool valid = true;
+        avlCheck(valid, tree.root());
+        if (!valid || tree.size() != (int)expected.size() || live != tree.size()) same = false;
+        if (tree.root() != nullptr && tree.root()->m_size != tree.size()) same = false;
+        // in order means largest first here
+        vector<pair<int, int>> visited;
+        tree.forEachInRange(2500, 500, [&visited](const int &key, const int &value){visited.push_back({key, value});});
+        vector<pair<int, int>> inRange(expected.lower_bound(2500), expected.upper_bound(500));
+        if (visited != inRange) same = false;
+        for (int key = -1; key <= 3001; key++){
+            const int *value = tree.find(key);
+            auto found = expected.find(key);
+            if ((value == nullptr) != (found == expected.end()) || (value != nullptr && *value != found->second)) same = false;
+        }
+    }
+    if (live != 0) same = false;
+    AvlTree<string, int> names;
+    names.insert("tiger", 1);
+    names.insert("lion", 2);
+    names.insert("cheetah", 3);
+    if (names.insert("lion", 4) || *names.find("lion") != 2 || names.find("puma") != nullptr || !names.remove("tiger")
+        || names.size() != 2) same = false;
+    if (same){
+        cout << "AVL TREE PASSED" << endl;
+    }else{
+        cout << "AVL TREE FAILED" << endl;
+    }
+}
 
-    int n = 2000;
-    double expectedRatio = (n * log2(n)) / ratio;
+template <class Node>
+int Tester::avlCheck(bool &valid, const Node *aNode) {
+    if (aNode == nullptr){
+        return -1;
+    }
+    int left = avlCheck(valid, aNode->m_left);
+    int right = avlCheck(valid, aNode->m_right);
+    if (left - right > 1 || right - left > 1) valid = false;
+    int height = (left > right ? left : right) + 1;
+    if (aNode->m_height != height) valid = false;
+    int size = 1 + (aNode->m_left == nullptr ? 0 : aNode->m_left->m_size)
+                 + (aNode->m_right == nullptr ? 0 : aNode->m_right->m_size);
+    if (aNode->m_size != size) valid = false;
+    return height;
+}
 
-    // getting my ratio and printing values
-    double myRatio = T2 / T1;
-    cout << "This is the expected ratio for remove (n=2000): " << expectedRatio << endl;
-    cout << "T2: " << T2 << ". T1: " << T1 << "." << endl;
-    cout << "This is my ratio: " << myRatio << endl;
+// returns the real height of a compact subtree, clears the flag if an id is out of order, a stored height is wrong or
+// a node is imbalanced
+int Tester::compactCheck(bool &valid, const CompactStreak &compact, uint32_t aTiger) {
+    if (aTiger == NIL){
+        return -1;
+    }
+    const CompactTiger &node = compact.m_nodes[aTiger];
+    if (node.m_left != NIL && compact.m_nodes[node.m_left].m_key >= node.m_key) valid = false;
+    if (node.m_right != NIL && compact.m_nodes[node.m_right].m_key <= node.m_key) valid = false;
+    int left = compactCheck(valid, compact, node.m_left);
+    int right = compactCheck(valid, compact, node.m_right);
+    if (left - right > 1 || right - left > 1) valid = false;
+    int height = (left > right ? left : right) + 1;
+    if ((int)node.m_height != height) valid = false;
+    return height;
+}
 
-    // checking if my ratio is acceptable
-    if ((expectedRatio - 0.4) < (myRatio) && (myRatio) < (expectedRatio + 0.4)) {
-        cout << "acceptable ratio" << endl;
+// builds streaks from batches with duplicates and out of range ids and compares them with inserting the same batch
+void Tester::bulkBuild() {
+    Random idGen(MINID - 100, MINID + 3000);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    Random stateGen(0,1);
+    bool built = true;
+    int sizes[] = {0, 1, 2, 3, 100, 5000};
+    for (int n : sizes){
+        vector<Tiger> batch;
+        for (int i = 0; i < n; i++){
+            batch.push_back(Tiger(idGen.getRandNum(),
+                                  static_cast<AGE>(ageGen.getRandNum()),
+                                  static_cast<GENDER>(genderGen.getRandNum()),
+                                  static_cast<STATE>(stateGen.getRandNum())));
+        }
+        Streak inserted;
+        for (const Tiger &tiger : batch){
+            inserted.insert(tiger);
+        }
+        // built from a vector on construction, and from a list into a streak that already has tigers
+        Streak streak(batch.begin(), batch.end());
+        list<Tiger> roster(batch.begin(), batch.end());
+        Streak rebuilt;
+        rebuilt.insert(Tiger(MAXID));
+        if (rebuilt.build(roster.begin(), roster.end()) != inserted.size()) built = false;
+
+        Streak *streaks[2] = {&streak, &rebuilt};
+        for (Streak *aStreak : streaks){
+            bool imbalanced = false;
+            imbalanceCheck(imbalanced, aStreak->m_root);
+            bool heights = true;
+            heightCheck(heights, aStreak->m_root);
+            bool counts = true;
+            countsCheck(counts, aStreak->m_root);
+            if (imbalanced || !heights || !counts || !checkBSTProperty(*aStreak)) built = false;
+            if (aStreak->size() != inserted.size()) built = false;
+            // the same tigers, with the attributes of the first one of every id
+            for (int i = 0; i < inserted.size(); i++){
+                int id = inserted.select(i);
+                Tiger *expected = inserted.getTiger(id);
+                if (aStreak->select(i) != id) built = false;
+                else if (aStreak->getTiger(id)->getAge() != expected->getAge()
+                    || aStreak->getTiger(id)->getGender() != expected->getGender()
+                    || aStreak->getTiger(id)->getState() != expected->getState()) built = false;
+            }
+        }
+        // the built streak keeps working with inserts and removes
+        streak.insert(Tiger(MAXID - 1));
+        streak.remove(MINID);
+        bool imbalanced = false;
+        imbalanceCheck(imbalanced, streak.m_root);
+        if (imbalanced || !streak.findTiger(MAXID - 1) || streak.findTiger(MINID)) built = false;
     }
+    if (built){
+        cout << "BULK BUILD PASSED" << endl;
+    }else{
+        cout << "BULK BUILD FAILED" << endl;
+    }
+}
 
-    // getting ratio and expected ratio for n = 3000
-    n = 3000;
-    expectedRatio = (n * log2(n)) / ratio;
+// inserts batches of several sizes, with duplicates inside the batch and against the streak, and compares the result
+// with an insert loop
+void Tester::batchInsert() {
+    Random idGen(MINID - 100, MINID + 20000);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    Random stateGen(0,1);
+    bool batched = true;
+    int streakSizes[] = {0, 1, 50, 10000};
+    int batchSizes[] = {0, 1, 7, 300, 10000};
+    for (int n : streakSizes){
+        for (int m : batchSizes){
+            vector<Tiger> roster;
+            vector<Tiger> batch;
+            for (int i = 0; i < n + m; i++){
+                Tiger tiger(idGen.getRandNum(),
+                            static_cast<AGE>(ageGen.getRandNum()),
+                            static_cast<GENDER>(genderGen.getRandNum()),
+                            static_cast<STATE>(stateGen.getRandNum()));
+                if (i < n) roster.push_back(tiger);
+                else batch.push_back(tiger);
+            }
+            Streak looped(roster.begin(), roster.end());
+            Streak merged(roster.begin(), roster.end());
+            int inserted = 0;
+            for (const Tiger &tiger : batch){
+                if (looped.insert(tiger) == INSERTED) inserted++;
+            }
+            if (merged.insertBatch(batch) != inserted || !sameStreak(looped, merged)) batched = false;
+        }
+    }
+    if (batched){
+        cout << "BATCH INSERT PASSED" << endl;
+    }else{
+        cout << "BATCH INSERT FAILED" << endl;
+    }
+}
 
-    // getting my ratio and printing values
+// runs every set operation on random streaks of several sizes and compares the result with insert and remove loops.
+// the tigers move between streaks, so the streaks are cleared and destroyed in mixed orders afterwards
+void Tester::setOperations() {
+    Random idGen(MINID, MINID + 20000);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    Random stateGen(0,1);
+    bool operations = true;
+    int sizes[] = {0, 1, 40, 5000};
+    for (int n : sizes){
+        for (int m : sizes){
+            vector<Tiger> ours;
+            vector<Tiger> theirs;
+            for (int i = 0; i < n + m; i++){
+                Tiger tiger(idGen.getRandNum(),
+                            static_cast<AGE>(ageGen.getRandNum()),
+                            static_cast<GENDER>(genderGen.getRandNum()),
+                            static_cast<STATE>(stateGen.getRandNum()));
+                if (i < n) ours.push_back(tiger);
+                else theirs.push_back(tiger);
+            }
+            Streak other(theirs.begin(), theirs.end());
+
+            // union, our tigers win
+            Streak united(ours.begin(), ours.end());
+            Streak unitedLoop(ours.begin(), ours.end());
+            int added = 0;
+            for (const Tiger &tiger : theirs){
+                if (unitedLoop.insert(tiger) == INSERTED) added++;
+            }
+            Streak moved(theirs.begin(), theirs.end());
+            if (united.unite(moved) != added || moved.size() != 0 || !sameStreak(unitedLoop, united)) operations = false;
+
+            // intersection and difference
+            Streak intersected(ours.begin(), ours.end());
+            Streak intersectedLoop(ours.begin(), ours.end());
+            Streak subtracted(ours.begin(), ours.end());
+            Streak subtractedLoop(ours.begin(), ours.end());
+            int kept = 0;
+            int removed = 0;
+            for (const Tiger &tiger : ours){
+                if (!other.findTiger(tiger.getID())) {
+                    if (intersectedLoop.remove(tiger.getID())) kept++;
+                }else if (subtractedLoop.remove(tiger.getID())){
+                    removed++;
+                }
+            }
+            Streak otherCopy(theirs.begin(), theirs.end());
+            if (intersected.intersect(otherCopy) != kept || otherCopy.size() != 0
+                || !sameStreak(intersectedLoop, intersected)) operations = false;
+            if (subtracted.subtract(other) != removed || other.size() != 0
+                || !sameStreak(subtractedLoop, subtracted)) operations = false;
+
+            // split at a random id and join the halves back, with and without a pivot
+            Streak whole(ours.begin(), ours.end());
+            Streak expected(ours.begin(), ours.end());
+            Streak right;
+            right.insert(Tiger(MAXID));
+            int id = idGen.getRandNum();
+            whole.split(id, right);
+            if ((whole.size() > 0 && whole.select(whole.size() - 1) >= id) || (right.size() > 0 && right.select(0) < id)
+                || whole.size() != expected.rank(id) || !sameStreak(whole, whole)) operations = false;
+            bool overlap = whole.size() > 0 && right.size() > 0;
+            if (right.join(whole) == overlap) operations = false;
+            if (!whole.join(right) || right.size() != 0 || !sameStreak(expected, whole)) operations = false;
+            if (whole.size() > 1){
+                Tiger pivot = *expected.getTiger(whole.select(whole.size() / 2));
+                whole.split(pivot.getID(), right);
+                right.remove(pivot.getID());
+                if (whole.join(Tiger(whole.select(0)), right) || !whole.join(pivot, right)
+                    || !sameStreak(expected, whole)) operations = false;
+            }
+
+            // the streaks that gave their tigers away keep working on their own, and the ones holding them are
+            // cleared or left to the destructors in a different order than they took them
+            moved.insert(Tiger(MINID));
+            otherCopy.insert(Tiger(MINID));
+            right.insert(Tiger(MAXID));
+            if (moved.size() != 1 || otherCopy.size() != 1 || right.size() != 1) operations = false;
+            united.clear();
+            whole.remove(whole.select(0));
+            whole.insert(Tiger(MAXID));
+            intersected.clear(true);
+            intersected.insert(Tiger(MAXID));
+            if (!intersected.findTiger(MAXID) || !whole.findTiger(MAXID)) operations = false;
+        }
+    }
+    if (operations){
+        cout << "SET OPERATIONS PASSED" << endl;
+    }else{
+        cout << "SET OPERATIONS FAILED" << endl;
+    }
+}
+
+// runs the parallel set operations with several thread counts on trees large enough to fork, and compares every
+// result and count with the sequential operation
+void Tester::parallelSetOperations() {
+    Random idGen(MINID, MAXID);
+    Random ageGen(0,2);
+    Random stateGen(0,1);
+    bool parallel = true;
+    int sizes[] = {100, 5000, 40000};
+    int threads[] = {1, 2, 4};
+    for (int n : sizes){
+        for (int m : sizes){
+            vector<Tiger> ours;
+            vector<Tiger> theirs;
+            for (int i = 0; i < n + m; i++){
+                Tiger tiger(idGen.getRandNum(), static_cast<AGE>(ageGen.getRandNum()), MALE,
+                            static_cast<STATE>(stateGen.getRandNum()));
+                if (i < n) ours.push_back(tiger);
+                else theirs.push_back(tiger);
+            }
+            for (int t : threads){
+                TaskPool tasks(t);
+                for (int operation = 0; operation < 3; operation++){
+                    Streak expected(ours.begin(), ours.end());
+                    Streak actual(ours.begin(), ours.end());
+                    Streak expectedOther(theirs.begin(), theirs.end());
+                    Streak actualOther(theirs.begin(), theirs.end());
+                    int expectedCount = 0;
+                    int actualCount = 0;
+                    if (operation == 0){
+                        expectedCount = expected.unite(expectedOther);
+                        actualCount = actual.unite(actualOther, tasks);
+                    }else if (operation == 1){
+                        expectedCount = expected.intersect(expectedOther);
+                        actualCount = actual.intersect(actualOther, tasks);
+                    }else{
+                        expectedCount = expected.subtract(expectedOther);
+                        actualCount = actual.subtract(actualOther, tasks);
+                    }
+                    if (expectedCount != actualCount || actualOther.size() != 0 || !sameStreak(expected, actual)){
+                        parallel = false;
+                    }
+                    // the freed tigers are back in the pool and get reused
+                    actual.insertBatch(theirs);
+                    expected.insertBatch(theirs);
+                    if (!sameStreak(expected, actual)) parallel = false;
+                }
+            }
+        }
+    }
+    if (parallel){
+        cout << "PARALLEL SET OPERATIONS PASSED" << endl;
+    }else{
+        cout << "PARALLEL SET OPERATIONS FAILED" << endl;
+    }
+}
+
+// runs the same random operations on a ConcurrentStreak and a Streak, then lets reader threads walk the published
+// trees while a writer changes them. the even ids are inserted first and never removed or killed, so every reader must
+// find all of them, and every tree a reader gets must be a valid AVL tree with correct counts
+void Tester::concurrentStreak() {
+    Random idGen(MINID - 10, MINID + 3000);
+    Random opGen(0, 4);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    bool same = true;
+    {
+        Streak streak;
+        ConcurrentStreak shared;
+        for (int i = 0; i < 30000; i++){
+            int id = idGen.getRandNum();
+            int op = opGen.getRandNum();
+            if (op < 2){
+                Tiger tiger(id, static_cast<AGE>(ageGen.getRandNum()), static_cast<GENDER>(genderGen.getRandNum()));
+                if (streak.insert(tiger) != shared.insert(tiger)) same = false;
+            }else if (op < 4){
+                if (streak.remove(id) != shared.remove(id)) same = false;
+            }else{
+                if (streak.setState(id, static_cast<STATE>(i % 2)) != shared.setState(id, static_cast<STATE>(i % 2))) same = false;
+            }
+            if (i % 10000 == 9999 && streak.removeDead() != shared.removeDead()) same = false;
+        }
+        for (int id = MINID - 10; id <= MINID + 3000; id++){
+            Tiger tiger;
+            Tiger *expected = streak.findTiger(id) ? streak.getTiger(id) : nullptr;
+            if (shared.getTiger(id, tiger) != (expected != nullptr) || shared.findTiger(id) != (expected != nullptr)){
+                same = false;
+            }else if (expected != nullptr && (tiger.getID() != id || tiger.getAge() != expected->getAge()
+                      || tiger.getGender() != expected->getGender() || tiger.getState() != expected->getState())){
+                same = false;
+            }
+        }
+        if (streak.size() != shared.size() || streak.countTigerCubs() != shared.countTigerCubs()
+            || streak.countBy(DEAD) != shared.countBy(DEAD)) same = false;
+        for (int g = MALE; g <= UNKNOWN; g++){
+            if (streak.countBy(static_cast<GENDER>(g)) != shared.countBy(static_cast<GENDER>(g))) same = false;
+        }
+        sharedCheck(same, shared.m_root.load(), MINID - 1, MAXID + 1);
+        // with no reader inside, a publish frees what earlier updates retired
+        if (shared.m_retired.size() >= RECLAIMBATCH) same = false;
+        // a write that finds nothing to do is one read-only descent, the published root stays
+        SharedTiger *root = shared.m_root.load();
+        shared.insert(Tiger(root->m_id));
+        shared.remove(MINID - 5);
+        shared.setState(root->m_id, unpackState(root->m_attrs));
+        if (shared.m_root.load() != root) same = false;
+        shared.clear();
+        if (shared.size() != 0 || shared.findTiger(MINID) || shared.insert(Tiger(MINID - 1)) != OUTOFRANGE) same = false;
+    }
+
+    ConcurrentStreak shared;
+    Streak streak;
+    for (int id = MINID; id < MINID + 2000; id += 2){
+        shared.insert(Tiger(id, CUB));
+        streak.insert(Tiger(id, CUB));
+    }
+    atomic<bool> writing(true);
+    atomic<bool> valid(true);
+    vector<thread> readers;
+    for (int t = 0; t < 3; t++){
+        readers.push_back(thread([this, &shared, &writing, &valid](){
+            do{
+                bool ok = true;
+                {
+                    ConcurrentStreak::ReadGuard guard(shared);
+                    SharedTiger *root = guard.root();
+                    sharedCheck(ok, root, MINID - 1, MAXID + 1);
+                    for (int id = MINID; id < MINID + 2000; id += 2){
+                        if (ConcurrentStreak::find(root, id) == nullptr) ok = false;
+                    }
+                }
+                if (shared.countBy(CUB) < 1000 || !shared.findTiger(MINID + 1000)) ok = false;
+                if (!ok) valid = false;
+            }while (writing);
+        }));
+    }
+    Random oddGen(0, 999);
+    for (int i = 0; i < 20000; i++){
+        int id = MINID + 2 * oddGen.getRandNum() + 1;
+        int op = opGen.getRandNum();
+        if (op < 2){
+            Tiger tiger(id, static_cast<AGE>(ageGen.getRandNum()), static_cast<GENDER>(genderGen.getRandNum()));
+            if (streak.insert(tiger) != shared.insert(tiger)) same = false;
+        }else if (op < 4){
+            if (streak.remove(id) != shared.remove(id)) same = false;
+        }else{
+            if (streak.setState(id, DEAD) != shared.setState(id, DEAD)) same = false;
+        }
+        if (i % 5000 == 4999 && streak.removeDead() != shared.removeDead()) same = false;
+    }
+    writing = false;
+    for (thread &reader : readers){
+        reader.join();
+    }
+    for (int id = MINID; id < MINID + 2000; id++){
+        if (streak.findTiger(id) != shared.findTiger(id)) same = false;
+    }
+    if (streak.size() != shared.size() || streak.countBy(DEAD) != shared.countBy(DEAD)) same = false;
+    if (same && valid){
+        cout << "CONCURRENT STREAK PASSED" << endl;
+    }else{
+        cout << "CONCURRENT STREAK FAILED" << endl;
+    }
+}
+
+void Tester::epochReaders() {
+    bool same = true;
+    {
+        // the readers past READERSLOTS share the overflow slot, which keeps the epoch of the first of them
+        EpochDomain domain;
+        vector<unique_ptr<EpochDomain::Guard>> guards;
+        for (int i = 0; i < 2 * READERSLOTS; i++){
+            guards.push_back(unique_ptr<EpochDomain::Guard>(new EpochDomain::Guard(domain)));
+            domain.advance();
+        }
+        if (domain.oldest() != 1) same = false;
+        guards.erase(guards.begin(), guards.begin() + READERSLOTS + 1);
+        if (domain.oldest() != READERSLOTS + 1) same = false;
+        guards.resize(1);
+        if (domain.oldest() != READERSLOTS + 1) same = false;
+        guards.clear();
+        if (domain.oldest() != domain.current()) same = false;
+        EpochDomain::Guard guard(domain);
+        if (guard.m_slot == EpochDomain::OVERFLOWSLOT) same = false;
+    }
+    // more reader threads than slots next to a writer, none of them waits for a slot
+    ConcurrentStreak shared;
+    for (int id = MINID; id < MINID + 1000; id += 2){
+        shared.insert(Tiger(id, CUB));
+    }
+    atomic<bool> writing(true);
+    atomic<bool> valid(true);
+    vector<thread> readers;
+    for (int t = 0; t < READERSLOTS + 32; t++){
+        readers.push_back(thread([&shared, &writing, &valid](){
+            do{
+                if (!shared.findTiger(MINID) || shared.countBy(CUB) < 500) valid = false;
+                this_thread::yield();
+            }while (writing);
+        }));
+    }
+    for (int i = 0; i < 1000; i++){
+        int id = MINID + 2 * (i % 500) + 1;
+        if (shared.insert(Tiger(id, CUB)) != INSERTED || !shared.remove(id)) same = false;
+    }
+    writing = false;
+    for (thread &reader : readers){
+        reader.join();
+    }
+    if (shared.size() != 500) same = false;
+    if (same && valid){
+        cout << "EPOCH READERS PASSED" << endl;
+    }else{
+        cout << "EPOCH READERS FAILED" << endl;
+    }
+}
+
+// returns the height of a ConcurrentStreak subtree, clears the flag if an id is outside (lo, hi), a stored height or
+// count is wrong or a node is imbalanced
+int Tester::sharedCheck(bool &valid, const SharedTiger *aTiger, int lo, int hi) {
+    if (aTiger == nullptr){
+        return -1;
+    }
+    if (aTiger->m_id <= lo || aTiger->m_id >= hi){
+        valid = false;
+    }
+    int left = sharedCheck(valid, aTiger->m_left, lo, aTiger->m_id);
+    int right = sharedCheck(valid, aTiger->m_right, aTiger->m_id, hi);
+    int height = (left > right ? left : right) + 1;
+    if (aTiger->m_height != height || left - right > 1 || right - left > 1){
+        valid = false;
+    }
+    int counts[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    counts[unpackAge(aTiger->m_attrs)]++;
+    counts[3 + unpackGender(aTiger->m_attrs)]++;
+    counts[6 + unpackState(aTiger->m_attrs)]++;
+    const SharedTiger *children[2] = {aTiger->m_left, aTiger->m_right};
+    for (const SharedTiger *child : children){
+        if (child != nullptr){
+            for (int i = 0; i < 3; i++){
+                counts[i] += child->m_ages[i];
+                counts[3 + i] += child->m_genders[i];
+            }
+            counts[6] += child->m_states[ALIVE];
+            counts[7] += child->m_states[DEAD];
+        }
+    }
+    for (int i = 0; i < 3; i++){
+        if (counts[i] != aTiger->m_ages[i] || counts[3 + i] != aTiger->m_genders[i]) valid = false;
+    }
+    if (counts[6] != aTiger->m_states[ALIVE] || counts[7] != aTiger->m_states[DEAD]) valid = false;
+    return height;
+}
+
+// copies Streaks and assigns them, then takes ConcurrentStreak snapshots every few thousand random operations and
+// keeps a Streak copy of the same state beside each. after the operations every snapshot has to hold exactly its
+// state, and a thread taking snapshots next to a writer only ever gets valid trees
+void Tester::snapshots() {
+    Random idGen(MINID, MINID + 4000);
+    Random opGen(0, 4);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    bool same = true;
+    {
+        Streak streak;
+        for (int i = 0; i < 3000; i++){
+            streak.insert(Tiger(idGen.getRandNum(), static_cast<AGE>(ageGen.getRandNum()),
+                                static_cast<GENDER>(genderGen.getRandNum()), static_cast<STATE>(i % 2)));
+        }
+        Streak copy(streak);
+        if (!sameStreak(streak, copy)) same = false;
+        int size = streak.size();
+        copy.removeDead();
+        copy.insert(Tiger(MAXID));
+        if (streak.size() != size || streak.findTiger(MAXID) || !streak.countBy(DEAD)) same = false;
+        streak = copy;
+        streak = streak;
+        if (!sameStreak(copy, streak)) same = false;
+        Streak empty;
+        copy = empty;
+        Streak emptyCopy(empty);
+        if (copy.size() != 0 || copy.m_root != nullptr || !sameStreak(empty, emptyCopy)) same = false;
+    }
+
+    ConcurrentStreak shared;
+    {
+        Streak streak;
+        vector<StreakSnapshot> snapshots;
+        vector<Streak> states;
+        snapshots.push_back(shared.snapshot());
+        states.push_back(streak);
+        for (int i = 0; i < 30000; i++){
+            int id = idGen.getRandNum();
+            int op = opGen.getRandNum();
+            if (op < 2){
+                Tiger tiger(id, static_cast<AGE>(ageGen.getRandNum()), static_cast<GENDER>(genderGen.getRandNum()));
+                if (streak.insert(tiger) != shared.insert(tiger)) same = false;
+            }else if (op < 4){
+                if (streak.remove(id) != shared.remove(id)) same = false;
+            }else{
+                if (streak.setState(id, static_cast<STATE>(i % 2)) != shared.setState(id, static_cast<STATE>(i % 2))) same = false;
+            }
+            if (i % 7000 == 6999 && streak.removeDead() != shared.removeDead()) same = false;
+            if (i == 20000){
+                streak.clear();
+                shared.clear();
+            }
+            if (i % 2500 == 0){
+                snapshots.push_back(shared.snapshot());
+                states.push_back(streak);
+            }
+        }
+        snapshots.push_back(shared.snapshot());
+        states.push_back(streak);
+        for (unsigned int i = 0; i < snapshots.size(); i++){
+            if (!sameSnapshot(snapshots[i], states[i])) same = false;
+        }
+        // copies share the tree, and the tree stays until the last handle on it is gone
+        StreakSnapshot copy(snapshots[3]);
+        copy = snapshots[5];
+        copy = copy;
+        snapshots[5] = snapshots[0];
+        if (!sameSnapshot(copy, states[5]) || !sameSnapshot(snapshots[5], states[0])) same = false;
+        shuffle(snapshots.begin() + 1, snapshots.end(), mt19937(10));
+        while (snapshots.size() > 1){
+            snapshots.pop_back();
+            int id = idGen.getRandNum();
+            if (streak.remove(id) != shared.remove(id)) same = false;
+        }
+        if (!sameSnapshot(copy, states[5]) || !sameSnapshot(snapshots[0], states[0])) same = false;
+        if (!sameSnapshot(shared.snapshot(), streak)) same = false;
+    }
+
+    atomic<bool> writing(true);
+    atomic<bool> valid(true);
+    thread reader([this, &shared, &writing, &valid](){
+        do{
+            StreakSnapshot snapshot = shared.snapshot();
+            bool ok = true;
+            sharedCheck(ok, snapshot.m_root, MINID - 1, MAXID + 1);
+            int size = 0;
+            snapshot.forEachInRange(MINID, MAXID, [&size](const Tiger &){size++;});
+            if (size != snapshot.size() || snapshot.countInRange(MINID, MAXID) != size) ok = false;
+            if (!ok) valid = false;
+        }while (writing);
+    });
+    for (int i = 0; i < 20000; i++){
+        int id = idGen.getRandNum();
+        if (opGen.getRandNum() < 2) shared.insert(Tiger(id));
+        else shared.remove(id);
+        if (i % 5000 == 4999) shared.removeDead();
+    }
+    writing = false;
+    reader.join();
+    if (same && valid){
+        cout << "SNAPSHOTS PASSED" << endl;
+    }else{
+        cout << "SNAPSHOTS FAILED" << endl;
+    }
+}
+
+// compares the tigers, counts, ranks and range counts of a snapshot with a streak, and checks the snapshot's tree
+bool Tester::sameSnapshot(const StreakSnapshot &snapshot, Streak &streak) {
+    bool same = snapshot.size() == streak.size() && snapshot.countTigerCubs() == streak.countTigerCubs()
+                && snapshot.countBy(DEAD) == streak.countBy(DEAD) && snapshot.countBy(FEMALE) == streak.countBy(FEMALE);
+    vector<uint32_t> expected;
+    vector<uint32_t> actual;
+    streak.forEachInRange(MINID, MAXID, [&expected](const Tiger &tiger){expected.push_back(Streak::pack(tiger));});
+    snapshot.forEachInRange(MINID, MAXID, [&actual](const Tiger &tiger){actual.push_back(Streak::pack(tiger));});
+    if (expected != actual) same = false;
+    if (snapshot.countInRange(INT_MIN, INT_MAX) != streak.size() || snapshot.countInRange(MAXID + 1, INT_MAX) != 0) same = false;
+    for (int id = MINID; id <= MINID + 4000; id += 97){
+        Tiger tiger;
+        if (snapshot.findTiger(id) != streak.findTiger(id) || snapshot.getTiger(id, tiger) != streak.findTiger(id)
+            || snapshot.rank(id) != streak.rank(id) || snapshot.countInRange(id, id + 500) != streak.countInRange(id, id + 500)){
+            same = false;
+        }else if (streak.findTiger(id) && Streak::pack(tiger) != Streak::pack(*streak.getTiger(id))){
+            same = false;
+        }
+    }
+    sharedCheck(same, snapshot.m_root, MINID - 1, MAXID + 1);
+    return same;
+}
+
+// runs random operations on an OptimisticStreak and a Streak from one thread, then checks results that any
+// linearizable order of concurrent operations has to give: of several threads inserting or removing the same ids
+// exactly one succeeds per id, a thread that alone changes some ids sees them as if no other thread ran, and ids no
+// one touches are always found. once the threads are done the tree has to be a valid AVL tree again
+void Tester::optimisticStreak() {
+    Random idGen(MINID - 10, MINID + 3000);
+    Random opGen(0, 4);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    bool same = true;
+    bool valid = true;
+    {
+        Streak streak;
+        OptimisticStreak optimistic;
+        for (int i = 0; i < 30000; i++){
+            int id = idGen.getRandNum();
+            int op = opGen.getRandNum();
+            if (op < 2){
+                Tiger tiger(id, static_cast<AGE>(ageGen.getRandNum()), static_cast<GENDER>(genderGen.getRandNum()));
+                if (streak.insert(tiger) != optimistic.insert(tiger)) same = false;
+            }else if (op < 4){
+                if (streak.remove(id) != optimistic.remove(id)) same = false;
+            }else{
+                if (streak.setState(id, static_cast<STATE>(i % 2)) != optimistic.setState(id, static_cast<STATE>(i % 2))) same = false;
+            }
+            if (i % 10000 == 9999 && streak.removeDead() != optimistic.removeDead()) same = false;
+            if (i % 1000 == 0) optimisticCheck(valid, optimistic.m_holder.m_right, &optimistic.m_holder, MINID - 1, MAXID + 1);
+        }
+        for (int id = MINID - 10; id <= MINID + 3000; id++){
+            Tiger tiger;
+            if (optimistic.findTiger(id) != streak.findTiger(id) || optimistic.getTiger(id, tiger) != streak.findTiger(id)){
+                same = false;
+            }else if (streak.findTiger(id) && Streak::pack(tiger) != Streak::pack(*streak.getTiger(id))){
+                same = false;
+            }
+        }
+        if (streak.size() != optimistic.size() || streak.countTigerCubs() != optimistic.countTigerCubs()
+            || streak.countBy(DEAD) != optimistic.countBy(DEAD) || streak.countBy(FEMALE) != optimistic.countBy(FEMALE)) same = false;
+        optimistic.clear();
+        if (optimistic.size() != 0 || optimistic.findTiger(MINID) || optimistic.insert(Tiger(MAXID + 1)) != OUTOFRANGE
+            || optimistic.insert(Tiger(MAXID)) != INSERTED || !optimistic.findTiger(MAXID)) same = false;
+    }
+
+    const int threads = 4;
+    const int ids = 2000;
+    OptimisticStreak optimistic;
+    vector<atomic<int>> wins(ids);
+    for (int phase = 0; phase < 2; phase++){
+        for (atomic<int> &win : wins) win.store(0);
+        vector<thread> writers;
+        for (int t = 0; t < threads; t++){
+            writers.push_back(thread([&optimistic, &wins, phase, t](){
+                vector<int> order;
+                for (int i = 0; i < ids; i++) order.push_back(i);
+                shuffle(order.begin(), order.end(), mt19937(t));
+                for (int i : order){
+                    if (phase == 0 && optimistic.insert(Tiger(MINID + i, CUB)) == INSERTED) wins[i]++;
+                    if (phase == 1 && optimistic.remove(MINID + i)) wins[i]++;
+                    optimistic.setState(MINID + order[(i * 7) % ids], DEAD);
+                }
+            }));
+        }
+        for (thread &writer : writers) writer.join();
+        for (atomic<int> &win : wins){
+            if (win != 1) same = false;
+        }
+        if (optimistic.size() != (phase == 0 ? ids : 0) || optimistic.countTigerCubs() != optimistic.size()) same = false;
+        optimisticCheck(valid, optimistic.m_holder.m_right, &optimistic.m_holder, MINID - 1, MAXID + 1);
+    }
+
+    // the ids from stable on are never changed, every other id belongs to the thread with id % threads == t
+    const int stable = MINID + 5000;
+    for (int id = stable; id < stable + 500; id++){
+        optimistic.insert(Tiger(id, YOUNG, FEMALE));
+    }
+    atomic<bool> writing(true);
+    vector<map<int, uint32_t>> models(threads);
+    vector<thread> writers;
+    thread reader([&optimistic, &writing, &same, stable](){
+        bool found = true;
+        do{
+            for (int id = stable; id < stable + 500; id++){
+                if (!optimistic.findTiger(id)) found = false;
+            }
+        }while (writing);
+        if (!found) same = false;
+    });
+    vector<int> mismatches(threads, 0);
+    for (int t = 0; t < threads; t++){
+        writers.push_back(thread([&optimistic, &models, &mismatches, t](){
+            mt19937 gen(100 + t);
+            map<int, uint32_t> &model = models[t];
+            for (int i = 0; i < 20000; i++){
+                int id = MINID + (int)(gen() % 1000) * threads + t;
+                int op = gen() % 5;
+                Tiger tiger(id, static_cast<AGE>(gen() % 3), static_cast<GENDER>(gen() % 3));
+                if (op < 2){
+                    bool inserted = optimistic.insert(tiger) == INSERTED;
+                    if (inserted != (model.count(id) == 0)) mismatches[t]++;
+                    if (inserted) model[id] = Streak::pack(tiger);
+                }else if (op < 3){
+                    if (optimistic.remove(id) != (model.erase(id) == 1)) mismatches[t]++;
+                }else if (op < 4){
+                    bool changed = optimistic.setState(id, DEAD);
+                    if (changed != (model.count(id) == 1)) mismatches[t]++;
+                    if (changed) model[id] = Streak::pack(Tiger(id, unpackAge(model[id] & 0xFF),
+                                                                unpackGender(model[id] & 0xFF), DEAD));
+                }else{
+                    Tiger found;
+                    bool there = optimistic.getTiger(id, found);
+                    if (there != (model.count(id) == 1) || (there && Streak::pack(found) != model[id])) mismatches[t]++;
+                }
+            }
+        }));
+    }
+    for (thread &writer : writers) writer.join();
+    writing = false;
+    reader.join();
+    int expected = 500;
+    int dead = 0;
+    for (int t = 0; t < threads; t++){
+        if (mismatches[t] != 0) same = false;
+        expected += models[t].size();
+        for (auto &entry : models[t]){
+            Tiger found;
+            if (!optimistic.getTiger(entry.first, found) || Streak::pack(found) != entry.second) same = false;
+            if (unpackState(entry.second & 0xFF) == DEAD) dead++;
+        }
+    }
+    if (optimistic.size() != expected || optimistic.countBy(DEAD) != dead) same = false;
+    optimisticCheck(valid, optimistic.m_holder.m_right, &optimistic.m_holder, MINID - 1, MAXID + 1);
+    if (optimistic.removeDead() != dead || optimistic.size() != expected - dead) same = false;
+    optimisticCheck(valid, optimistic.m_holder.m_right, &optimistic.m_holder, MINID - 1, MAXID + 1);
+    if (same && valid){
+        cout << "OPTIMISTIC STREAK PASSED" << endl;
+    }else{
+        cout << "OPTIMISTIC STREAK FAILED" << endl;
+    }
+}
+
+// returns the height of an OptimisticStreak subtree, clears the flag if an id is outside (lo, hi), a parent link, a
+// stored height or a version is wrong, or a node is imbalanced. only for a tree no thread is changing
+int Tester::optimisticCheck(bool &valid, OptimisticTiger *node, OptimisticTiger *parent, int lo, int hi) {
+    if (node == nullptr){
+        return 0;
+    }
+    if (node->m_id <= lo || node->m_id >= hi || node->m_parent != parent || node->m_version % 4 != 0){
+        valid = false;
+    }
+    int left = optimisticCheck(valid, node->m_left, node, lo, node->m_id);
+    int right = optimisticCheck(valid, node->m_right, node, node->m_id, hi);
+    int height = max(left, right) + 1;
+    if (node->m_height != height || left - right > 1 || right - left > 1){
+        valid = false;
+    }
+    return height;
+}
+
+// checks if two streaks hold the same tigers with the same attributes, and if the second one is balanced with correct
+// heights, counts and BST property
+bool Tester::sameStreak(Streak &expected, Streak &actual) {
+    bool same = expected.size() == actual.size();
+    for (int i = 0; same && i < expected.size(); i++){
+        int id = expected.select(i);
+        Tiger *a = expected.getTiger(id);
+        if (actual.select(i) != id) same = false;
+        else if (actual.getTiger(id)->getAge() != a->getAge() || actual.getTiger(id)->getGender() != a->getGender()
+                 || actual.getTiger(id)->getState() != a->getState()) same = false;
+    }
+    bool imbalanced = false;
+    imbalanceCheck(imbalanced, actual.m_root);
+    bool heights = true;
+    heightCheck(heights, actual.m_root);
+    bool counts = true;
+    countsCheck(counts, actual.m_root);
+    return same && !imbalanced && heights && counts && checkBSTProperty(actual);
+}
+
+// runs the same random operations on ShardedStreaks of several shard counts and on a Streak, ids spread over the whole
+// range so every shard and both range ends are hit, and compares the results, the counts and the listing. then
+// threads that own every eighth id change the shards at once while a reader looks up ids no one changes
+void Tester::shardedStreak() {
+    Random slotGen(0, 2999);
+    Random opGen(0, 4);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    bool same = true;
+    int shardCounts[] = {1, 7, SHARDS};
+    for (int shards : shardCounts){
+        Streak streak;
+        ShardedStreak sharded(shards);
+        if (sharded.shards() != shards || sharded.shardOf(MINID) != 0 || sharded.shardOf(MAXID) != shards - 1) same = false;
+        for (int i = 0; i < 30000; i++){
+            int id = MINID - 5 + slotGen.getRandNum() * 31;
+            int op = opGen.getRandNum();
+            if (op < 2){
+                Tiger tiger(id, static_cast<AGE>(ageGen.getRandNum()), static_cast<GENDER>(genderGen.getRandNum()));
+                if (streak.insert(tiger) != sharded.insert(tiger)) same = false;
+            }else if (op < 4){
+                if (streak.remove(id) != sharded.remove(id)) same = false;
+            }else{
+                if (streak.setState(id, static_cast<STATE>(i % 2)) != sharded.setState(id, static_cast<STATE>(i % 2))) same = false;
+            }
+            if (i % 10000 == 9999 && streak.removeDead() != sharded.removeDead()) same = false;
+        }
+        for (int slot = 0; slot < 3000; slot++){
+            if (streak.findTiger(MINID - 5 + slot * 31) != sharded.findTiger(MINID - 5 + slot * 31)) same = false;
+        }
+        if (streak.size() != sharded.size() || streak.countTigerCubs() != sharded.countTigerCubs()
+            || streak.countBy(DEAD) != sharded.countBy(DEAD) || streak.countBy(FEMALE) != sharded.countBy(FEMALE)
+            || streak.countBy(OLD) != sharded.countBy(OLD)) same = false;
+        // the listing has to come out in one increasing order across the shards
+        stringstream expected;
+        stringstream actual;
+        streambuf *out = cout.rdbuf(expected.rdbuf());
+        streak.listTigers();
+        cout.rdbuf(actual.rdbuf());
+        sharded.listTigers();
+        cout.rdbuf(out);
+        if (expected.str() != actual.str()) same = false;
+
+        vector<Tiger> batch;
+        for (int i = 0; i < 5000; i++){
+            batch.push_back(Tiger(MINID - 5 + slotGen.getRandNum() * 31, CUB, MALE, static_cast<STATE>(i % 3 == 0)));
+        }
+        TaskPool tasks(4);
+        ShardedStreak parallel(shards);
+        parallel.insertBatch(batch, tasks);
+        int inserted = streak.insertBatch(batch);
+        if (sharded.insertBatch(batch) != inserted || parallel.size() != Streak(batch.begin(), batch.end()).size()) same = false;
+        int dead = parallel.countBy(DEAD);
+        if (streak.removeDead() != sharded.removeDead(tasks) || parallel.removeDead(tasks) != dead
+            || parallel.countBy(DEAD) != 0 || streak.size() != sharded.size()) same = false;
+        sharded.clear();
+        if (sharded.size() != 0 || sharded.insert(Tiger(MAXID + 1)) != OUTOFRANGE || sharded.insert(Tiger(MAXID)) != INSERTED
+            || !sharded.findTiger(MAXID) || sharded.remove(MINID - 1)) same = false;
+    }
+
+    const int threads = 4;
+    ShardedStreak sharded;
+    const int stable = MINID + 7;
+    for (int id = stable; id <= MAXID; id += 184){
+        sharded.insert(Tiger(id, YOUNG, FEMALE));
+    }
+    const int stableCount = sharded.size();
+    atomic<bool> writing(true);
+    vector<map<int, STATE>> models(threads);
+    vector<int> mismatches(threads, 0);
+    thread reader([&sharded, &writing, &same, stable, stableCount](){
+        bool found = true;
+        do{
+            for (int id = stable; id <= MAXID; id += 184){
+                if (!sharded.findTiger(id)) found = false;
+            }
+            if (sharded.countBy(FEMALE) < stableCount) found = false;
+        }while (writing);
+        if (!found) same = false;
+    });
+    vector<thread> writers;
+    for (int t = 0; t < threads; t++){
+        writers.push_back(thread([&sharded, &models, &mismatches, t](){
+            mt19937 gen(200 + t);
+            map<int, STATE> &model = models[t];
+            for (int i = 0; i < 20000; i++){
+                // the ids t apart from a multiple of 8 above MINID, the stable ones are 7 apart
+                int id = MINID + (int)(gen() % ((MAXID - MINID) / 8)) * 8 + t;
+                int op = gen() % 4;
+                if (op == 0){
+                    bool inserted = sharded.insert(Tiger(id, CUB, MALE)) == INSERTED;
+                    if (inserted != (model.count(id) == 0)) mismatches[t]++;
+                    if (inserted) model[id] = ALIVE;
+                }else if (op == 1){
+                    if (sharded.remove(id) != (model.erase(id) == 1)) mismatches[t]++;
+                }else if (op == 2){
+                    bool changed = sharded.setState(id, DEAD);
+                    if (changed != (model.count(id) == 1)) mismatches[t]++;
+                    if (changed) model[id] = DEAD;
+                }else if (sharded.findTiger(id) != (model.count(id) == 1)){
+                    mismatches[t]++;
+                }
+            }
+        }));
+    }
+    for (thread &writer : writers) writer.join();
+    writing = false;
+    reader.join();
+    int expected = stableCount;
+    int dead = 0;
+    for (int t = 0; t < threads; t++){
+        if (mismatches[t] != 0) same = false;
+        expected += models[t].size();
+        for (auto &entry : models[t]){
+            if (!sharded.findTiger(entry.first)) same = false;
+            if (entry.second == DEAD) dead++;
+        }
+    }
+    TaskPool tasks(threads);
+    if (sharded.size() != expected || sharded.countBy(MALE) != expected - stableCount || sharded.removeDead(tasks) != dead
+        || sharded.size() != expected - dead) same = false;
+    if (same){
+        cout << "SHARDED STREAK PASSED" << endl;
+    }else{
+        cout << "SHARDED STREAK FAILED" << endl;
+    }
+}
+
+// saves streaks of several sizes (empty, one tiger, a sparse roster and every id) and loads them into streaks that
+// already hold tigers, which have to come out the same as the original. then changed, cut and forged files (bad
+// version, zero or out of range deltas, bad attributes, each with a correct checksum) have to be turned away with the
+// streak left as it was
+void Tester::saveLoad() {
+    Random idGen(MINID, MAXID);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    Random stateGen(0,1);
+    const string path = "mytest.snapshot";
+    bool saved = true;
+    int sizes[] = {0, 1, 5000, MAXID - MINID + 1};
+    for (int n : sizes){
+        Streak original;
+        for (int i = 0; original.size() < n; i++){
+            int id = n == MAXID - MINID + 1 ? MINID + i : idGen.getRandNum();
+            original.insert(Tiger(id, static_cast<AGE>(ageGen.getRandNum()), static_cast<GENDER>(genderGen.getRandNum()),
+                                  static_cast<STATE>(stateGen.getRandNum())));
+        }
+        Streak loaded;
+        loaded.insert(Tiger(MINID + 17));
+        if (!original.save(path) || !loaded.load(path) || !sameStreak(original, loaded)) saved = false;
+        if (n == 5000){
+            // one byte of id delta and one of attributes per tiger, against a line of text
+            stringstream text;
+            streambuf *out = cout.rdbuf(text.rdbuf());
+            original.listTigers();
+            cout.rdbuf(out);
+            ifstream file(path, ios::binary | ios::ate);
+            if (file.tellg() * 5 > (streamoff)text.str().size()) saved = false;
+        }
+    }
+
+    Streak original;
+    for (int i = 0; i < 1000; i++){
+        original.insert(Tiger(idGen.getRandNum(), static_cast<AGE>(ageGen.getRandNum())));
+    }
+    original.save(path);
+    ifstream file(path, ios::binary);
+    const vector<uint8_t> image((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    file.close();
+    // writes image with a checksum that matches, or keeps the old one
+    auto write = [&path](vector<uint8_t> bytes, bool fixChecksum){
+        if (fixChecksum){
+            uint32_t crc = crc32(bytes.data(), bytes.size() - 4);
+            for (int byte = 0; byte < 4; byte++) bytes[bytes.size() - 4 + byte] = (crc >> (8 * byte)) & 0xFF;
+        }
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    };
+    vector<vector<uint8_t>> forged;
+    vector<bool> fixed;
+    vector<uint8_t> bad = image;
+    bad[image.size() / 2] ^= 0x10;//flipped bit
+    forged.push_back(bad);
+    fixed.push_back(false);
+    forged.push_back(vector<uint8_t>(image.begin(), image.end() - 1));//cut short
+    fixed.push_back(false);
+    bad = image;
+    bad[4] = SNAPSHOTVERSION + 1;
+    forged.push_back(bad);
+    fixed.push_back(true);
+    bad = image;
+    bad[SNAPSHOTHEADER + 3] = 0;//a delta of zero is a duplicate, unless a varint ended right before
+    forged.push_back(bad);
+    fixed.push_back(true);
+    bad = image;
+    bad[image.size() - 5] = 0x3F;//attributes with bits packAttrs never sets
+    forged.push_back(bad);
+    fixed.push_back(true);
+    bad = image;
+    bad[8]++;//one tiger more than there are bytes for
+    forged.push_back(bad);
+    fixed.push_back(true);
+    vector<uint8_t> far(image.begin(), image.begin() + SNAPSHOTHEADER);
+    far[8] = 1;
+    far[9] = far[10] = far[11] = 0;
+    far.push_back(0xFF);
+    far.push_back(0xFF);
+    far.push_back(0x07);//a delta of 2^17 - 1, past MAXID
+    far.push_back(0);
+    far.insert(far.end(), 4, 0);
+    forged.push_back(far);
+    fixed.push_back(true);
+    Streak kept(original);
+    for (unsigned int i = 0; i < forged.size(); i++){
+        write(forged[i], fixed[i]);
+        if (kept.load(path) || !sameStreak(original, kept)){
+            saved = false;
+        }
+    }
+    write(image, false);
+    if (!kept.load(path) || !sameStreak(original, kept)) saved = false;
+    std::remove(path.c_str());
+    if (kept.load(path) || original.save("no-such-directory/" + path) || !sameStreak(original, kept)) saved = false;
+    if (saved){
+        cout << "SAVE LOAD PASSED" << endl;
+    }else{
+        cout << "SAVE LOAD FAILED" << endl;
+    }
+}
+
+// writes images of streaks of several sizes and maps each one twice, both maps have to answer every query the way
+// the streak does. a map keeps the image it opened when a new one is saved over it, a forked process can open the
+// same file, and files that are not images are turned away. a changed node passes open but not verify
+void Tester::mappedStreak() {
+    Random idGen(MINID, MAXID);
+    Random ageGen(0,2);
+    Random genderGen(0,2);
+    Random stateGen(0,1);
+    const string path = "mytest.image";
+    bool mapped = true;
+    int sizes[] = {0, 1, 5000, MAXID - MINID + 1};
+    for (int n : sizes){
+        Streak streak;
+        for (int i = 0; streak.size() < n; i++){
+            int id = n == MAXID - MINID + 1 ? MINID + i : idGen.getRandNum();
+            streak.insert(Tiger(id, static_cast<AGE>(ageGen.getRandNum()), static_cast<GENDER>(genderGen.getRandNum()),
+                                static_cast<STATE>(stateGen.getRandNum())));
+        }
+        MappedStreak first;
+        MappedStreak second;
+        if (!streak.saveImage(path) || !first.open(path) || !second.open(path) || !first.verify()) mapped = false;
+        for (MappedStreak *image : {&first, &second}){
+            if (!sameImage(*image, streak)) mapped = false;
+        }
+        for (int i = 0; i < 2000; i++){
+            int lo = idGen.getRandNum() - 50;
+            int hi = lo + i;
+            if (first.rank(lo) != streak.rank(lo) || second.countInRange(lo, hi) != streak.countInRange(lo, hi)) mapped = false;
+        }
+        if (first.countInRange(MINID - 100, MAXID + 100) != n || first.countInRange(MAXID + 1, MAXID + 5) != 0) mapped = false;
+    }
+
+    Streak streak;
+    for (int i = 0; i < 1000; i++){
+        streak.insert(Tiger(idGen.getRandNum(), static_cast<AGE>(ageGen.getRandNum())));
+    }
+    Streak older(streak);
+    MappedStreak image;
+    streak.saveImage(path);
+    image.open(path);
+    streak.insert(Tiger(MINID));
+    streak.remove(MAXID);
+    streak.saveImage(path);
+    if (!sameImage(image, older)) mapped = false;
+    image.open(path);
+    if (!sameImage(image, streak)) mapped = false;
+    pid_t child = fork();
+    if (child == 0){
+        MappedStreak shared;
+        _exit(shared.open(path) && shared.verify() && shared.size() == streak.size() ? 0 : 1);
+    }
+    int status = 1;
+    if (child < 0 || waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) mapped = false;
+
+    ifstream file(path, ios::binary);
+    vector<char> bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    file.close();
+    image.close();
+    auto write = [&path](const vector<char> &contents){
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(contents.data(), contents.size());
+    };
+    vector<char> bad = bytes;
+    bad[0] ^= 1;
+    write(bad);
+    if (image.open(path) || image.size() != 0 || image.findTiger(MINID)) mapped = false;
+    write(vector<char>(bytes.begin(), bytes.end() - 1));
+    if (image.open(path)) mapped = false;
+    bad = bytes;
+    bad[sizeof(ImageHeader) + 5 * sizeof(CompactTiger) + 8] ^= 0x40;
+    write(bad);
+    if (!image.open(path) || image.verify()) mapped = false;
+    image.close();
+    // children past the last node and a cycle open but can not send a lookup outside the map or round forever
+    bad = bytes;
+    CompactTiger *nodes = reinterpret_cast<CompactTiger*>(bad.data() + sizeof(ImageHeader));
+    nodes[reinterpret_cast<ImageHeader*>(bad.data())->m_root].m_left = 0xFFFFFFF0;
+    nodes[1].m_left = 1;
+    nodes[1].m_right = 1;
+    nodes[2].m_right = 1 << 20;
+    write(bad);
+    if (!image.open(path) || image.verify()) mapped = false;
+    for (int id = MINID - 5; id <= MAXID + 5; id++){
+        Tiger tiger;
+        if (image.getTiger(id, tiger) && tiger.getID() != id) mapped = false;
+        if (image.rank(id) < 0 || image.rank(id) > image.size()) mapped = false;
+    }
+    image.close();
+    std::remove(path.c_str());
+    if (image.open(path) || image.verify() || image.countInRange(MINID, MAXID) != 0) mapped = false;
+    if (mapped){
+        cout << "MAPPED STREAK PASSED" << endl;
+    }else{
+        cout << "MAPPED STREAK FAILED" << endl;
+    }
+}
+
+// checks if a mapped image holds the tigers of a streak: lookups on every id, the in order visit and listing, and the
+// counts
+bool Tester::sameImage(const MappedStreak &image, Streak &streak) {
+    bool same = image.size() == streak.size() && image.countTigerCubs() == streak.countTigerCubs()
+                && image.countBy(DEAD) == streak.countBy(DEAD) && image.countBy(FEMALE) == streak.countBy(FEMALE)
+                && image.countBy(OLD) == streak.countBy(OLD);
+    for (int id = MINID - 5; id <= MAXID + 5; id++){
+        Tiger tiger;
+        if (image.findTiger(id) != streak.findTiger(id) || image.getTiger(id, tiger) != streak.findTiger(id)){
+            same = false;
+        }else if (streak.findTiger(id) && Streak::pack(tiger) != Streak::pack(*streak.getTiger(id))){
+            same = false;
+        }
+    }
+    vector<uint32_t> expected;
+    vector<uint32_t> actual;
+    streak.forEachInRange(MINID + 100, MAXID - 100, [&expected](const Tiger &tiger){expected.push_back(Streak::pack(tiger));});
+    image.forEachInRange(MINID + 100, MAXID - 100, [&actual](const Tiger &tiger){actual.push_back(Streak::pack(tiger));});
+    stringstream expectedText;
+    stringstream actualText;
+    streambuf *out = cout.rdbuf(expectedText.rdbuf());
+    streak.listTigers();
+    cout.rdbuf(actualText.rdbuf());
+    image.listTigers();
+    cout.rdbuf(out);
+    return same && expected == actual && expectedText.str() == actualText.str();
+}
+
+// runs random updates on a streak with a journal attached and on a plain one, and recovers a third streak from the
+// snapshot and the journal after every round: it has to match. a torn record at the end is dropped and appending
+// carries on after the last whole one, a journal from before a compaction is not replayed on the new snapshot, and
+// the flusher makes a lone update durable within the delay
+void Tester::journal() {
+    Random idGen(MINID, MINID + 2000);
+    Random opGen(0, 9);
+    Random ageGen(0,2);
+    const string snapshot = "mytest.snapshot";
+    const string path = "mytest.journal";
+    std::remove(snapshot.c_str());
+    std::remove(path.c_str());
+    bool journaled = true;
+    Streak expected;
+    Streak streak;
+    StreakJournal journal;
+    if (journal.recover(snapshot, path, streak, 16, 1000000) != 0 || streak.size() != 0) journaled = false;
+    auto recovered = [this, &snapshot, &path, &expected](int records){
+        Streak copy;
+        StreakJournal other;
+        int replayed = other.recover(snapshot, path, copy);
+        other.close();
+        return (records < 0 || replayed == records) && sameStreak(expected, copy);
+    };
+    for (int round = 0; round < 4; round++){
+        for (int i = 0; i < 3000; i++){
+            int id = idGen.getRandNum();
+            int op = opGen.getRandNum();
+            if (op < 4){
+                Tiger tiger(id, static_cast<AGE>(ageGen.getRandNum()), FEMALE);
+                if (expected.insert(tiger) != streak.insert(tiger)) journaled = false;
+            }else if (op < 7){
+                if (expected.remove(id) != streak.remove(id)) journaled = false;
+            }else if (op < 9){
+                if (expected.setState(id, static_cast<STATE>(i % 2)) != streak.setState(id, static_cast<STATE>(i % 2))) journaled = false;
+            }else if (i % 100 == 0){
+                if (expected.removeDead() != streak.removeDead()) journaled = false;
+            }
+        }
+        if (!journal.sync() || journal.durable() != journal.appended() || !recovered(-1)) journaled = false;
+        if (round == 1){
+            if (!journal.compact() || !recovered(0)) journaled = false;
+            ifstream file(path, ios::binary | ios::ate);
+            if (file.tellg() != JOURNALHEADER) journaled = false;
+        }
+    }
+    // the bulk updates record the tigers they add or take away instead of saving a new snapshot
+    auto synced = [&journal, &recovered](int records){
+        return journal.sync() && recovered(records);
+    };
+    if (!journal.compact()) journaled = false;
+    vector<Tiger> batch = {Tiger(MINID + 2500), Tiger(MINID + 2501, OLD), Tiger(MINID + 2502, CUB, MALE, DEAD),
+                           Tiger(MINID + 2500, OLD)};
+    if (expected.insertBatch(batch) != 3 || streak.insertBatch(batch) != 3 || !synced(3)) journaled = false;
+    Streak right;
+    Streak expectedRight;
+    expected.split(MINID + 1000, expectedRight);
+    streak.split(MINID + 1000, right);
+    int moved = right.size();
+    if (moved == 0 || !synced(3 + moved)) journaled = false;
+    if (!expected.join(expectedRight) || !streak.join(right) || !synced(3 + 2 * moved)) journaled = false;
+    Streak other;
+    Streak expectedOther;
+    for (int id : {MINID + 2500, MINID + 2600, MINID + 2601}){
+        other.insert(Tiger(id, YOUNG));
+        expectedOther.insert(Tiger(id, YOUNG));
+    }
+    if (expected.unite(expectedOther) != 2 || streak.unite(other) != 2 || !synced(5 + 2 * moved)) journaled = false;
+    for (int id : {MINID + 2600, MINID + 2700}){
+        other.insert(Tiger(id));
+        expectedOther.insert(Tiger(id));
+    }
+    if (expected.subtract(expectedOther) != 1 || streak.subtract(other) != 1) journaled = false;
+    if (!synced(6 + 2 * moved)) journaled = false;
+    // setting a tiger to the state it has already is no update and appends no record
+    uint64_t appended = journal.appended();
+    if (!streak.setState(MINID + 2502, DEAD) || journal.appended() != appended) journaled = false;
+    if (journal.appended() == 0) journaled = false;
+    // a whole-tree update whose compaction can not save the snapshot closes the journal, and sync says so
+    journal.m_snapshot = "mytest.missing/" + snapshot;
+    streak = expected;
+    if (journal.sync() || journal.m_streak != nullptr || streak.m_journal != nullptr) journaled = false;
+    journal.m_snapshot = snapshot;
+    if (!recovered(6 + 2 * moved)) journaled = false;
+    if (journal.recover(snapshot, path, streak, 16, 1000000) < 0 || !journal.sync()) journaled = false;
+
+    // a torn last record, then appending goes on from the last whole one
+    journal.close();
+    {
+        ofstream torn(path, ios::binary | ios::app);
+        torn.write("\x01\x02\x03\x04\x05", 5);
+    }
+    if (journal.recover(snapshot, path, streak, 4, 1000000) < 0 || !sameStreak(expected, streak)) journaled = false;
+    expected.insert(Tiger(MAXID, OLD));
+    streak.insert(Tiger(MAXID, OLD));
+    journal.sync();
+    if (journal.syncs() != 1 || !recovered(-1)) journaled = false;
+    // a write that fails keeps its records, sync says so, and the next flush writes them after the last good record
+    int file = journal.m_file;
+    journal.m_file = open(path.c_str(), O_RDONLY);
+    expected.insert(Tiger(MAXID - 2, OLD));
+    streak.insert(Tiger(MAXID - 2, OLD));
+    if (journal.sync() || journal.durable() == journal.appended()) journaled = false;
+    ::close(journal.m_file);
+    journal.m_file = file;
+    if (!journal.sync() || journal.durable() != journal.appended() || !recovered(-1)) journaled = false;
+    // the flusher syncs a lone record once the delay is up
+    journal.close();
+    journal.recover(snapshot, path, streak, 1000, 2000);
+    expected.remove(MAXID);
+    streak.remove(MAXID);
+    this_thread::sleep_for(chrono::milliseconds(50));
+    if (journal.durable() != 1 || journal.syncs() != 1) journaled = false;
+
+    // a crash between saving the snapshot and starting the new journal leaves the old journal next to the new snapshot
+    ifstream oldJournal(path, ios::binary);
+    const string before((istreambuf_iterator<char>(oldJournal)), istreambuf_iterator<char>());
+    oldJournal.close();
+    expected.insert(Tiger(MAXID - 1));
+    streak.insert(Tiger(MAXID - 1));
+    if (!journal.compact()) journaled = false;
+    journal.close();
+    {
+        ofstream stale(path, ios::binary | ios::trunc);
+        stale.write(before.data(), before.size());
+    }
+    if (before.size() <= (size_t)JOURNALHEADER || !recovered(0)) journaled = false;
+    // a streak that goes before its journal closes it, with its last records synced
+    {
+        StreakJournal outlives;
+        {
+            Streak gone;
+            outlives.recover(snapshot, path, gone, 1000, 1000000);
+            gone.insert(Tiger(MINID + 3000));
+        }
+        if (outlives.m_streak != nullptr || outlives.durable() != 1) journaled = false;
+    }
+    std::remove(snapshot.c_str());
+    std::remove(path.c_str());
+    if (journaled){
+        cout << "JOURNAL PASSED" << endl;
+    }else{
+        cout << "JOURNAL FAILED" << endl;
+    }
+}
+
+// checks time complexity for insertion time (if it is accepted)
+void Tester::insertTime() {
+    // creating a tree of 1000 nodes and getting the start time and end time of insertion
+    Streak streak;
+
+    auto startTime = clock();
+    for (int i = 0; i < 1000; i++) {
+        Tiger tiger(MINID+i);
+        streak.insert(tiger);
+    }
+    // getting T1 and clearing the tree
+    auto endTime = clock();
+    double T1 = endTime - startTime;
+    streak.clear();
+
+    // getting T2, 2000 nodes
+    startTime = clock();
+    for (int i = 0; i < 2000; i++) {
+        Tiger tiger(MINID+i);
+        streak.insert(tiger);
+    }
+    endTime = clock();
+    double T2 = endTime - startTime;
+    streak.clear();
+
+    // T3, 3000 nodes
+    startTime = clock();
+    for (int i = 0; i < 3000; i++) {
+        Tiger tiger(MINID+i);
+        streak.insert(tiger);
+    }
+    endTime = clock();
+    double T3 = endTime - startTime;
+    streak.clear();
+
+    // calculating the ratio
+    double ratio = 1000*log2(1000);
+
+    // calculating expected ratio of current insertions
+    int n = 2000;
+    double expectedRatio = (n*log2(n))/ratio;
+
+    // calculating my ratio and printing values
+    double myRatio = T2/T1;
+    cout << "This is the expected ratio for insert (n=2000): " << expectedRatio << endl;
+    cout << "T2: " << T2 << ". T1: " << T1  << "." << endl;
+    cout << "This is my ratio: " << myRatio << endl;
+
+    // checking if my ratio is acceptable
+    if ((expectedRatio-0.4) < (myRatio) && (myRatio) < (expectedRatio+0.4)){
+        cout << "acceptable ratio" << endl;
+    }
+
+    // calculating expected ratio of current insertions
+    n = 3000;
+    expectedRatio = (n*log2(n))/ratio;
+
+    // calculating my ratio and printing values
+    myRatio = T3/T1;
+    cout << "This is the expected ratio for insert (n=3000): " << expectedRatio << endl;
+    cout << "T3: " << T3 << ". T1: " << "." << T1 << endl;
+    cout << "This is my ratio: " << myRatio << endl;
+
+    // checking if my ratio is acceptable
+    if ((expectedRatio-0.4) < (myRatio) && (myRatio) < (expectedRatio+0.4)){
+        cout << "acceptable ratio" << endl;
+    }
+}
+
+
+// checking time complexity of remove
+void Tester::removeTime() {
+    // creating a tree
+    Streak streak;
+
+    // getting T1, removal of 1000 nodes
+    for (int i = 0; i < 1000; i++) {
+        Tiger tiger(MINID + i);
+        streak.insert(tiger);
+    }
+    auto startTime = clock();
+    for (int i = 0; i < 1000; i++) {
+        streak.remove(MINID + i);
+    }
+    auto endTime = clock();
+    double T1 = endTime - startTime;
+    streak.clear();
+
+    // getting T2, removal of 2000 nodes
+    for (int i = 0; i < 2000; i++) {
+        Tiger tiger(MINID + i);
+        streak.insert(tiger);
+    }
+    startTime = clock();
+    for (int i = 0; i < 2000; i++) {
+        streak.remove(MINID + i);
+    }
+    endTime = clock();
+    double T2 = endTime - startTime;
+    streak.clear();
+
+    // getting T3, removal of 3000 nodes
+    for (int i = 0; i < 3000; i++) {
+        Tiger tiger(MINID + i);
+        streak.insert(tiger);
+    }
+    startTime = clock();
+    for (int i = 0; i < 3000; i++) {
+        streak.remove(MINID + i);
+    }
+    endTime = clock();
+    double T3 = endTime - startTime;
+    streak.clear();
+
+    // getting ratio and expected ratio for n = 2000
+    double ratio = 1000 * log2(1000);
+
+    int n = 2000;
+    double expectedRatio = (n * log2(n)) / ratio;
+
+    // getting my ratio and printing values
+    double myRatio = T2 / T1;
+    cout << "This is the expected ratio for remove (n=2000): " << expectedRatio << endl;
+    cout << "T2: " << T2 << ". T1: " << T1 << "." << endl;
+    cout << "This is my ratio: " << myRatio << endl;
+
+    // checking if my ratio is acceptable
+    if ((expectedRatio - 0.4) < (myRatio) && (myRatio) < (expectedRatio + 0.4)) {
+        cout << "acceptable ratio" << endl;
+    }
+
+    // getting ratio and expected ratio for n = 3000
+    n = 3000;
+    expectedRatio = (n * log2(n)) / ratio;
+
+    // getting my ratio and printing values
     myRatio = T3 / T1;
     cout << "This is the expected ratio for remove (n=3000): " << expectedRatio << endl;
     cout << "T3: " << T3 << ". T1: " << T1 << "." << endl;
@@ -982,3 +2927,749 @@ void Tester::removeTime() {
         cout << "acceptable ratio" << endl;
     }
 }
+
+
+// microbenchmark for remove, counts the nodes each remove visits and compares it to the height of the tree. the count
+// comes from the tree before the remove: the descent to the id and on to its successor, and retrace, which walks the
+// same links back up once
+void Tester::removeVisits() {
+    int sizes[] = {1000, 10000, 80000};
+    bool bounded = true;
+    for (int n : sizes){
+        // inserting n ids in random order
+        vector<int> ids;
+        for (int i = 0; i < n; i++){
+            ids.push_back(MINID + i);
+        }
+        shuffle(ids.begin(), ids.end(), mt19937(10));
+        Streak streak;
+        for (int id : ids){
+            streak.insert(Tiger(id));
+        }
+
+        // removing all of them in a different random order
+        shuffle(ids.begin(), ids.end(), mt19937(20));
+        long total = 0;
+        double worst = 0;
+        double mean = 0;
+        for (int id : ids){
+            int height = streak.m_root->getHeight();
+            int visits = 0;
+            if (!streak.remove(id, visits)) bounded = false;
+            total += visits;
+            // a descent and a retrace can each visit at most height+1 nodes
+            if (visits > 2 * (height + 1)) bounded = false;
+            if ((double)visits / (height + 1) > worst) worst = (double)visits / (height + 1);
+            mean += (double)visits / (height + 1) / n;
+        }
+        cout << "remove (n=" << n << "): " << (double)total / n << " visits per remove, worst "
+             << worst << " x (height+1), mean " << mean << " x (height+1)" << endl;
+        // the retrace mostly stops after a few levels, a remove that went down the tree twice would be at 2 or more
+        if (mean > 1.75) bounded = false;
+        int visits = -1;
+        if (streak.remove(MINID, visits) || visits != 0) bounded = false;
+    }
+    if (bounded){
+        cout << "REMOVE VISITS PASSED" << endl;
+    }else{
+        cout << "REMOVE VISITS FAILED" << endl;
+    }
+}
+
+// benchmark on the 10k/100k insert workloads of insertLarge. every round fills the streak, looks up the whole id space
+// and clears it, once releasing the slab on clear() and once keeping it for the next round
+void Tester::slabTime() {
+    int sizes[] = {10000, 100000};
+    for (int n : sizes){
+        for (int keep = 0; keep < 2; keep++){
+            Random idGen(MINID,MAXID);
+            Streak streak;
+            double insertTicks = 0;
+            double findTicks = 0;
+            int found = 0;
+            for (int round = 0; round < 5; round++){
+                auto startTime = clock();
+                for (int i = 0; i < n; i++){
+                    streak.insert(Tiger(idGen.getRandNum()));
+                }
+                insertTicks += clock() - startTime;
+                startTime = clock();
+                for (int id = MINID; id <= MAXID; id++){
+                    found += streak.findTiger(id);
+                }
+                findTicks += clock() - startTime;
+                streak.clear(keep == 1);
+            }
+            cout << "slab " << (keep ? "kept" : "released") << " (n=" << n << "): insert " << insertTicks / 5
+                 << ", lookup " << findTicks / 5 << " ticks per round (" << found / 5 << " found)" << endl;
+        }
+    }
+}
+
+// compares node size and the time for random lookups in a Streak and a CompactStreak of n tigers
+void Tester::compactTime() {
+    int sizes[] = {10000, 80000};
+    cout << "node size: Tiger " << sizeof(Tiger) << " bytes, CompactTiger " << sizeof(CompactTiger) << " bytes" << endl;
+    for (int n : sizes){
+        Random idGen(MINID,MAXID);
+        Streak streak;
+        CompactStreak compact;
+        for (int i = 0; i < n; i++){
+            Tiger tiger(idGen.getRandNum());
+            streak.insert(tiger);
+            compact.insert(tiger);
+        }
+        vector<int> ids;
+        for (int i = 0; i < 500000; i++){
+            ids.push_back(idGen.getRandNum());
+        }
+        int found = 0;
+        auto startTime = clock();
+        for (int id : ids){
+            found += streak.findTiger(id);
+        }
+        double streakTicks = clock() - startTime;
+        startTime = clock();
+        for (int id : ids){
+            found -= compact.findTiger(id);
+        }
+        double compactTicks = clock() - startTime;
+        cout << "lookup (n=" << n << "): Streak " << streakTicks << ", CompactStreak " << compactTicks << " ticks"
+             << (found == 0 ? "" : " (MISMATCH)") << endl;
+    }
+}
+
+// lookups and state changes on a streak holding every id, as a Streak and as a DenseStreak
+void Tester::denseTime() {
+    Random idGen(MINID,MAXID);
+    Streak streak;
+    DenseStreak dense;
+    for (int id = MINID; id <= MAXID; id++){
+        streak.insert(Tiger(id));
+        dense.insert(Tiger(id));
+    }
+    vector<int> ids;
+    for (int i = 0; i < 500000; i++){
+        ids.push_back(idGen.getRandNum());
+    }
+    int found = 0;
+    auto startTime = clock();
+    for (int id : ids){
+        found += streak.findTiger(id);
+        streak.setState(id, static_cast<STATE>(id & 1));
+    }
+    double streakTicks = clock() - startTime;
+    startTime = clock();
+    for (int id : ids){
+        found -= dense.findTiger(id);
+        dense.setState(id, static_cast<STATE>(id & 1));
+    }
+    double denseTicks = clock() - startTime;
+    cout << "lookup+setState (n=" << IDRANGE << "): Streak " << streakTicks << ", DenseStreak " << denseTicks
+         << " ticks, DenseStreak memory " << IDRANGE + IDRANGE / 8 << " bytes" << (found == 0 ? "" : " (MISMATCH)")
+         << endl;
+}
+
+// random lookups on the live Streak and on its frozen view. ids only span MINID..MAXID, so the largest streak holds
+// every id
+void Tester::viewTime() {
+    int sizes[] = {1000, 10000, IDRANGE};
+    for (int n : sizes){
+        Random idGen(MINID,MAXID);
+        vector<Tiger> roster;
+        for (int i = 0; i < n; i++){
+            roster.push_back(Tiger(MINID + (long)i * IDRANGE / n));
+        }
+        Streak streak(roster.begin(), roster.end());
+        StreakView view = streak.freezeView();
+        vector<int> ids;
+        for (int i = 0; i < 2000000; i++){
+            ids.push_back(idGen.getRandNum());
+        }
+        int found = 0;
+        auto startTime = clock();
+        for (int id : ids){
+            found += streak.findTiger(id);
+        }
+        double streakTicks = clock() - startTime;
+        startTime = clock();
+        for (int id : ids){
+            found -= view.findTiger(id);
+        }
+        double viewTicks = clock() - startTime;
+        cout << "lookup (n=" << n << "): Streak " << streakTicks << ", StreakView " << viewTicks << " ticks"
+             << (found == 0 ? "" : " (MISMATCH)") << endl;
+    }
+}
+
+// random lookups and a full in order scan on a Streak and a BTreeStreak holding the same tigers
+void Tester::btreeTime() {
+    int sizes[] = {1000, 10000, IDRANGE};
+    for (int n : sizes){
+        Random idGen(MINID,MAXID);
+        Streak streak;
+        BTreeStreak btree;
+        for (int i = 0; i < n; i++){
+            Tiger tiger(MINID + (long)i * IDRANGE / n);
+            streak.insert(tiger);
+            btree.insert(tiger);
+        }
+        vector<int> ids;
+        for (int i = 0; i < 2000000; i++){
+            ids.push_back(idGen.getRandNum());
+        }
+        int found = 0;
+        auto startTime = clock();
+        for (int id : ids){
+            found += streak.findTiger(id);
+        }
+        double streakTicks = clock() - startTime;
+        startTime = clock();
+        for (int id : ids){
+            found -= btree.findTiger(id);
+        }
+        double btreeTicks = clock() - startTime;
+        // scans repeated to visit about 20M tigers
+        int rounds = 20000000 / n;
+        long scanned = 0;
+        startTime = clock();
+        for (int round = 0; round < rounds; round++){
+            streak.forEachInRange(MINID, MAXID, [&scanned](const Tiger &tiger){scanned += tiger.getID();});
+        }
+        double streakScan = clock() - startTime;
+        startTime = clock();
+        for (int round = 0; round < rounds; round++){
+            btree.forEachInRange(MINID, MAXID, [&scanned](const Tiger &tiger){scanned -= tiger.getID();});
+        }
+        double btreeScan = clock() - startTime;
+        cout << "n=" << n << ": lookup Streak " << streakTicks << ", BTreeStreak " << btreeTicks << " ticks; scan Streak "
+             << streakScan << ", BTreeStreak " << btreeScan << " ticks" << (found == 0 && scanned == 0 ? "" : " (MISMATCH)")
+             << endl;
+    }
+}
+
+// every id inserted in random order, looked up and removed in random order, on a Streak and on an AvlTree with the
+// same balancing but no subtree counts and the default allocator
+void Tester::avlTime() {
+    mt19937 generator(7);
+    vector<int> ids;
+    for (int id = MINID; id <= MAXID; id++){
+        ids.push_back(id);
+    }
+    shuffle(ids.begin(), ids.end(), generator);
+    Streak streak;
+    AvlTree<int, uint8_t> tree;
+    double ticks[2][3];
+    long found = 0;
+    for (int backend = 0; backend < 2; backend++){
+        auto startTime = clock();
+        for (int id : ids){
+            if (backend == 0) streak.insert(Tiger(id));
+            else tree.insert(id, packAttrs(DEFAULT_AGE, DEFAULT_GENDER, DEFAULT_STATE));
+        }
+        ticks[backend][0] = clock() - startTime;
+        startTime = clock();
+        for (int round = 0; round < 5; round++){
+            for (int id : ids){
+                if (backend == 0) found += streak.findTiger(id);
+                else found -= tree.find(id) != nullptr;
+            }
+        }
+        ticks[backend][1] = clock() - startTime;
+        startTime = clock();
+        for (int i = ids.size() - 1; i >= 0; i--){
+            if (backend == 0) streak.remove(ids[i]);
+            else tree.remove(ids[i]);
+        }
+        ticks[backend][2] = clock() - startTime;
+    }
+    cout << "avl (n=" << IDRANGE << "): insert Streak " << ticks[0][0] << ", AvlTree " << ticks[1][0] << "; lookup Streak "
+         << ticks[0][1] << ", AvlTree " << ticks[1][1] << "; remove Streak " << ticks[0][2] << ", AvlTree " << ticks[1][2]
+         << " ticks" << (found == 0 ? "" : " (MISMATCH)") << endl;
+}
+
+// loads a 1M record roster by inserting every record and by building from the whole batch
+void Tester::buildTime() {
+    Random idGen(MINID,MAXID);
+    Random ageGen(0,2);
+    vector<Tiger> roster;
+    for (int i = 0; i < 1000000; i++){
+        roster.push_back(Tiger(idGen.getRandNum(), static_cast<AGE>(ageGen.getRandNum())));
+    }
+    Streak inserted;
+    auto startTime = clock();
+    for (const Tiger &tiger : roster){
+        inserted.insert(tiger);
+    }
+    double insertTicks = clock() - startTime;
+    startTime = clock();
+    Streak built(roster.begin(), roster.end());
+    double buildTicks = clock() - startTime;
+    cout << "load 1M records (" << built.size() << " tigers): insert " << insertTicks << ", build " << buildTicks
+         << " ticks" << (built.size() == inserted.size() ? "" : " (MISMATCH)") << endl;
+}
+
+// merges batches of m tigers into a streak of n = 40000 with insertBatch and with an insert loop, for several m/n
+void Tester::batchTime() {
+    Random idGen(MINID,MAXID);
+    vector<Tiger> roster;
+    for (int i = 0; i < 40000; i++){
+        roster.push_back(Tiger(idGen.getRandNum()));
+    }
+    int batchSizes[] = {40, 400, 4000, 40000};
+    for (int m : batchSizes){
+        vector<Tiger> batch;
+        for (int i = 0; i < m; i++){
+            batch.push_back(Tiger(idGen.getRandNum()));
+        }
+        // repeats small batches so the clock can measure them
+        int rounds = 4000 / m + 1;
+        double loopTicks = 0;
+        double batchTicks = 0;
+        for (int round = 0; round < rounds; round++){
+            Streak looped(roster.begin(), roster.end());
+            Streak merged(roster.begin(), roster.end());
+            auto startTime = clock();
+            for (const Tiger &tiger : batch){
+                looped.insert(tiger);
+            }
+            loopTicks += clock() - startTime;
+            startTime = clock();
+            merged.insertBatch(batch);
+            batchTicks += clock() - startTime;
+        }
+        cout << "batch m/n=" << m / 40000.0 << ": insert loop " << loopTicks / rounds << ", insertBatch "
+             << batchTicks / rounds << " ticks" << endl;
+    }
+}
+
+// wall time of unite, intersect and subtract of two streaks of 45000 tigers (half of every id each) from 1 thread up
+// to every core, at least 4. clock() adds up the time of every thread, so this one measures wall time
+void Tester::parallelTime() {
+    Random idGen(MINID,MAXID);
+    vector<Tiger> ours;
+    vector<Tiger> theirs;
+    for (int i = 0; i < 45000; i++){
+        ours.push_back(Tiger(idGen.getRandNum()));
+        theirs.push_back(Tiger(idGen.getRandNum()));
+    }
+    int cores = thread::hardware_concurrency();
+    int rounds = 20;
+    for (int t = 1; t <= max(cores, 4); t *= 2){
+        TaskPool tasks(t);
+        double times[3] = {0, 0, 0};
+        for (int round = 0; round < rounds; round++){
+            for (int operation = 0; operation < 3; operation++){
+                Streak streak(ours.begin(), ours.end());
+                Streak other(theirs.begin(), theirs.end());
+                auto startTime = chrono::steady_clock::now();
+                if (operation == 0) streak.unite(other, tasks);
+                else if (operation == 1) streak.intersect(other, tasks);
+                else streak.subtract(other, tasks);
+                times[operation] += chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count();
+            }
+        }
+        cout << "parallel " << t << " threads (" << cores << " cores): unite " << times[0] / rounds << ", intersect "
+             << times[1] / rounds << ", subtract " << times[2] / rounds << " us" << endl;
+    }
+}
+
+// the same number of random lookups split over 1 to 64 reader threads, while one writer keeps changing states. the
+// readers of a ConcurrentStreak never wait, the ones of a Streak take a shared mutex with the writer. the writer's
+// update count shows how much it got done next to the readers
+void Tester::concurrentTime() {
+    Random idGen(MINID,MAXID);
+    vector<Tiger> roster;
+    for (int i = 0; i < 100000; i++){
+        roster.push_back(Tiger(idGen.getRandNum()));
+    }
+    ConcurrentStreak shared;
+    Streak streak(roster.begin(), roster.end());
+    mutex streakLock;
+    for (const Tiger &tiger : roster){
+        shared.insert(tiger);
+    }
+    vector<int> ids;
+    for (int i = 0; i < 1 << 20; i++){
+        ids.push_back(idGen.getRandNum());
+    }
+    int lookups = 2000000;
+    int cores = thread::hardware_concurrency();
+    for (int t = 1; t <= 64; t *= 2){
+        double times[2];
+        long updates[2];
+        for (int kind = 0; kind < 2; kind++){
+            atomic<bool> reading(true);
+            atomic<long> found(0);
+            updates[kind] = 0;
+            thread writer([&, kind](){
+                Random writeGen(0, (int)roster.size() - 1);
+                for (long i = 0; reading; i++){
+                    int id = roster[writeGen.getRandNum()].getID();
+                    if (kind == 0){
+                        shared.setState(id, static_cast<STATE>(i % 2));
+                    }else{
+                        lock_guard<mutex> lock(streakLock);
+                        streak.setState(id, static_cast<STATE>(i % 2));
+                    }
+                    updates[kind]++;
+                }
+            });
+            auto startTime = chrono::steady_clock::now();
+            vector<thread> readers;
+            for (int r = 0; r < t; r++){
+                readers.push_back(thread([&, r, kind](){
+                    long hits = 0;
+                    for (int i = r; i < lookups; i += t){
+                        int id = ids[i & (ids.size() - 1)];
+                        if (kind == 0){
+                            hits += shared.findTiger(id);
+                        }else{
+                            lock_guard<mutex> lock(streakLock);
+                            hits += streak.findTiger(id);
+                        }
+                    }
+                    found += hits;
+                }));
+            }
+            for (thread &reader : readers){
+                reader.join();
+            }
+            times[kind] = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+            reading = false;
+            writer.join();
+        }
+        cout << "concurrent " << t << " readers (" << cores << " cores): ConcurrentStreak " << times[0] << " ms ("
+             << updates[0] << " updates), Streak with mutex " << times[1] << " ms (" << updates[1] << " updates)"
+             << endl;
+    }
+}
+
+// a snapshot only takes a reference on the root, a Streak copy rebuilds every node. while snapshots are held the
+// nodes an update replaces stay with them instead of being retired, which is what the second line measures
+void Tester::snapshotTime() {
+    Random idGen(MINID,MAXID);
+    ConcurrentStreak shared;
+    Streak streak;
+    vector<int> ids;
+    for (int i = 0; i < 100000; i++){
+        Tiger tiger(idGen.getRandNum());
+        shared.insert(tiger);
+        streak.insert(tiger);
+        ids.push_back(tiger.getID());
+    }
+    int rounds = 100;
+    auto startTime = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++){
+        Streak copy(streak);
+    }
+    double copyTime = chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count() / rounds;
+    startTime = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++){
+        StreakSnapshot snapshot = shared.snapshot();
+    }
+    double snapshotTime = chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count() / rounds;
+    cout << "snapshot (n=" << streak.size() << "): Streak copy " << copyTime << " us, ConcurrentStreak snapshot "
+         << snapshotTime << " us" << endl;
+
+    int updates = 200000;
+    double times[2];
+    for (int held = 0; held < 2; held++){
+        vector<StreakSnapshot> snapshots;
+        startTime = chrono::steady_clock::now();
+        for (int i = 0; i < updates; i++){
+            shared.setState(ids[i % ids.size()], static_cast<STATE>(i % 2));
+            // a new snapshot every 100 updates, the oldest of the last 16 is dropped
+            if (held && i % 100 == 0){
+                snapshots.push_back(shared.snapshot());
+                if (snapshots.size() > 16) snapshots.erase(snapshots.begin());
+            }
+        }
+        times[held] = chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count();
+    }
+    cout << "setState x" << updates << ": no snapshot " << times[0] << " us, snapshot every 100 updates " << times[1]
+         << " us" << endl;
+}
+
+// every thread runs the same mix on its share of the operations: 70% lookups, 10% inserts, 10% removes and 10% state
+// changes on random ids. OptimisticStreak lets writers run side by side, ConcurrentStreak has one writer at a time
+// and lock-free readers, and a Streak behind a mutex lets one thread in at a time
+void Tester::optimisticTime() {
+    Random idGen(MINID,MAXID);
+    vector<Tiger> roster;
+    for (int i = 0; i < 50000; i++){
+        roster.push_back(Tiger(idGen.getRandNum()));
+    }
+    vector<int> ops;
+    for (int i = 0; i < 1 << 20; i++){
+        ops.push_back(idGen.getRandNum() * 10 + i % 10);
+    }
+    int total = 1000000;
+    int cores = thread::hardware_concurrency();
+    for (int t = 1; t <= 8; t *= 2){
+        OptimisticStreak optimistic;
+        ConcurrentStreak shared;
+        Streak streak(roster.begin(), roster.end());
+        mutex streakLock;
+        for (const Tiger &tiger : roster){
+            optimistic.insert(tiger);
+            shared.insert(tiger);
+        }
+        double times[3];
+        for (int kind = 0; kind < 3; kind++){
+            auto startTime = chrono::steady_clock::now();
+            vector<thread> workers;
+            for (int w = 0; w < t; w++){
+                workers.push_back(thread([&, w, kind](){
+                    for (int i = w; i < total; i += t){
+                        int id = ops[i & (ops.size() - 1)] / 10;
+                        int op = ops[i & (ops.size() - 1)] % 10;
+                        if (kind == 0){
+                            if (op < 7) optimistic.findTiger(id);
+                            else if (op == 7) optimistic.insert(Tiger(id));
+                            else if (op == 8) optimistic.remove(id);
+                            else optimistic.setState(id, DEAD);
+                        }else if (kind == 1){
+                            if (op < 7) shared.findTiger(id);
+                            else if (op == 7) shared.insert(Tiger(id));
+                            else if (op == 8) shared.remove(id);
+                            else shared.setState(id, DEAD);
+                        }else{
+                            lock_guard<mutex> lock(streakLock);
+                            if (op < 7) streak.findTiger(id);
+                            else if (op == 7) streak.insert(Tiger(id));
+                            else if (op == 8) streak.remove(id);
+                            else streak.setState(id, DEAD);
+                        }
+                    }
+                }));
+            }
+            for (thread &worker : workers){
+                worker.join();
+            }
+            times[kind] = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+        }
+        cout << "mixed " << t << " threads (" << cores << " cores): OptimisticStreak " << times[0]
+             << " ms, ConcurrentStreak " << times[1] << " ms, Streak with mutex " << times[2] << " ms" << endl;
+    }
+}
+
+// every thread runs the optimisticTime mix of 70% lookups and 10% each of inserts, removes and state changes. with
+// uniform ids the threads spread over all the shards, with skewed ids 90% of the operations fall in the range of one
+// shard. a Streak behind one mutex is the baseline
+void Tester::shardedTime() {
+    Random idGen(MINID,MAXID);
+    Random hotGen(MINID, MINID + (MAXID - MINID + 1) / SHARDS - 1);
+    Random pickGen(0, 9);
+    vector<Tiger> roster;
+    for (int i = 0; i < 50000; i++){
+        roster.push_back(Tiger(idGen.getRandNum()));
+    }
+    vector<int> uniform;
+    vector<int> skewed;
+    for (int i = 0; i < 1 << 20; i++){
+        uniform.push_back(idGen.getRandNum() * 10 + i % 10);
+        skewed.push_back((pickGen.getRandNum() < 9 ? hotGen.getRandNum() : idGen.getRandNum()) * 10 + i % 10);
+    }
+    int total = 1000000;
+    int cores = thread::hardware_concurrency();
+    for (int skew = 0; skew < 2; skew++){
+        const vector<int> &ops = skew == 0 ? uniform : skewed;
+        for (int t = 1; t <= 8; t *= 2){
+            ShardedStreak sharded;
+            sharded.insertBatch(roster);
+            Streak streak(roster.begin(), roster.end());
+            mutex streakLock;
+            double times[2];
+            for (int kind = 0; kind < 2; kind++){
+                auto startTime = chrono::steady_clock::now();
+                vector<thread> workers;
+                for (int w = 0; w < t; w++){
+                    workers.push_back(thread([&, w, kind](){
+                        for (int i = w; i < total; i += t){
+                            int id = ops[i & (ops.size() - 1)] / 10;
+                            int op = ops[i & (ops.size() - 1)] % 10;
+                            if (kind == 0){
+                                if (op < 7) sharded.findTiger(id);
+                                else if (op == 7) sharded.insert(Tiger(id));
+                                else if (op == 8) sharded.remove(id);
+                                else sharded.setState(id, DEAD);
+                            }else{
+                                lock_guard<mutex> lock(streakLock);
+                                if (op < 7) streak.findTiger(id);
+                                else if (op == 7) streak.insert(Tiger(id));
+                                else if (op == 8) streak.remove(id);
+                                else streak.setState(id, DEAD);
+                            }
+                        }
+                    }));
+                }
+                for (thread &worker : workers){
+                    worker.join();
+                }
+                times[kind] = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+            }
+            cout << (skew == 0 ? "uniform" : "skewed") << " ids " << t << " threads (" << cores << " cores): ShardedStreak ("
+                 << sharded.shards() << " shards) " << times[0] << " ms, Streak with mutex " << times[1] << " ms" << endl;
+        }
+    }
+}
+
+// saves a roster of 50000 tigers and restores it, against writing the listTigers text and reading it back line by
+// line with an insert per tiger, the way a roster was kept before
+void Tester::saveTime() {
+    Random idGen(MINID,MAXID);
+    Random ageGen(0,2);
+    Streak roster;
+    while (roster.size() < 50000){
+        roster.insert(Tiger(idGen.getRandNum(), static_cast<AGE>(ageGen.getRandNum())));
+    }
+    const string path = "mytest.snapshot";
+    auto startTime = chrono::steady_clock::now();
+    roster.save(path);
+    double saveTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    startTime = chrono::steady_clock::now();
+    Streak loaded;
+    loaded.load(path);
+    double loadTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    ifstream file(path, ios::binary | ios::ate);
+    long binaryBytes = file.tellg();
+    file.close();
+    std::remove(path.c_str());
+
+    startTime = chrono::steady_clock::now();
+    stringstream text;
+    streambuf *out = cout.rdbuf(text.rdbuf());
+    roster.listTigers();
+    cout.rdbuf(out);
+    double listTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    startTime = chrono::steady_clock::now();
+    Streak parsed;
+    string line;
+    while (getline(text, line)){
+        size_t age = line.find(':');
+        size_t gender = line.find(':', age + 1);
+        size_t state = line.find(':', gender + 1);
+        string ageText = line.substr(age + 1, gender - age - 1);
+        string genderText = line.substr(gender + 1, state - gender - 1);
+        parsed.insert(Tiger(stoi(line.substr(0, age)), ageText == "CUB" ? CUB : ageText == "YOUNG" ? YOUNG : OLD,
+                            genderText == "MALE" ? MALE : genderText == "FEMALE" ? FEMALE : UNKNOWN,
+                            line.substr(state + 1) == "DEAD" ? DEAD : ALIVE));
+    }
+    double parseTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    cout << "snapshot " << roster.size() << " tigers: save " << saveTime << " ms, load " << loadTime << " ms, "
+         << binaryBytes << " bytes; text " << listTime << " ms, parse and insert " << parseTime << " ms, "
+         << text.str().size() << " bytes" << (loaded.size() == parsed.size() ? "" : " (MISMATCH)") << endl;
+}
+
+// a warm start from a tree image against loading the binary snapshot of the same 50000 tigers, and random lookups on
+// the mapped image against the loaded Streak
+void Tester::mappedTime() {
+    Random idGen(MINID,MAXID);
+    Streak roster;
+    while (roster.size() < 50000){
+        roster.insert(Tiger(idGen.getRandNum()));
+    }
+    roster.save("mytest.snapshot");
+    roster.saveImage("mytest.image");
+    auto startTime = chrono::steady_clock::now();
+    Streak loaded;
+    loaded.load("mytest.snapshot");
+    double loadTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    startTime = chrono::steady_clock::now();
+    MappedStreak image;
+    image.open("mytest.image");
+    double openTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    vector<int> ids;
+    for (int i = 0; i < 2000000; i++){
+        ids.push_back(idGen.getRandNum());
+    }
+    int found = 0;
+    startTime = chrono::steady_clock::now();
+    for (int id : ids){
+        found += loaded.findTiger(id);
+    }
+    double streakTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    startTime = chrono::steady_clock::now();
+    for (int id : ids){
+        found -= image.findTiger(id);
+    }
+    double imageTime = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    image.close();
+    std::remove("mytest.snapshot");
+    std::remove("mytest.image");
+    cout << "warm start " << roster.size() << " tigers: load snapshot " << loadTime << " ms, map image " << openTime
+         << " ms; 2M lookups: Streak " << streakTime << " ms, MappedStreak " << imageTime << " ms"
+         << (found == 0 ? "" : " (MISMATCH)") << endl;
+}
+
+// inserts and removes with a journal attached, syncing every batch records, from one fsync per update to one per 512.
+// the delay is long enough that the flusher never runs, so the batch size alone decides how often the disk syncs
+void Tester::feedParsing() {
+    bool same = true;
+    // each rejection reason, and the line endings
+    const char *lines[] = {"10000,0,1,0", "10001,2,2,1\r", "", "\r", "10002,1,0", "x,0,0,0", "10003,0,0,0,0", "10004,0,0,0 ",
+                           "10005,,0,0", "99999999999,0,0,0", "-1,0,0,0", "999999,0,0,0", "10006,3,0,0", "10007,0,3,0",
+                           "10008,0,0,2", "10009,-1,0,0"};
+    vector<Tiger> batch;
+    IngestCounts counts;
+    for (const char *line : lines){
+        parseLine(line, line + strlen(line), batch, counts);
+    }
+    if (counts.m_lines != 14 || counts.m_malformed != 6 || counts.m_outOfRange != 2 || counts.m_badEnum != 4) same = false;
+    if (batch.size() != 2 || batch[0].getID() != 10000 || batch[0].getGender() != FEMALE
+        || batch[1].getID() != 10001 || batch[1].getAge() != OLD || batch[1].getState() != DEAD) same = false;
+    // a whole feed with CRLF lines, a duplicate, a line longer than the block and no newline after the last line
+    const string path = "mytest.feed";
+    string feed = "10000,0,0,0\r\n10001,1,1,1\r\n10000,2,2,0\r\n" + string(100, '1') + "\n\n10002,2,1,0\n10003,0,0,0";
+    ofstream(path, ios::binary) << feed;
+    for (size_t block : {(size_t)4, (size_t)7, INGESTBLOCK}){
+        Streak streak;
+        IngestCounts fed;
+        int file = open(path.c_str(), O_RDONLY);
+        if (!ingestFeed(file, streak, fed, block, 2)) same = false;
+        close(file);
+        if (fed.m_bytes != (long)feed.size() || fed.m_lines != 6 || fed.m_inserted != 4 || fed.m_duplicates != 1
+            || fed.m_malformed != 1 || streak.size() != 4 || !streak.findTiger(10003)) same = false;
+        Tiger *tiger = streak.getTiger(10001);
+        if (tiger == nullptr || tiger->getAge() != YOUNG || tiger->getState() != DEAD) same = false;
+    }
+    std::remove(path.c_str());
+    // a file that can not be read
+    Streak streak;
+    IngestCounts fed;
+    if (ingestFeed(-1, streak, fed)) same = false;
+    if (same){
+        cout << "FEED PARSING PASSED" << endl;
+    }else{
+        cout << "FEED PARSING FAILED" << endl;
+    }
+}
+
+void Tester::journalTime() {
+    Random idGen(MINID,MAXID);
+    const string snapshot = "mytest.snapshot";
+    const string path = "mytest.journal";
+    int batches[] = {1, 8, 64, 512};
+    const int updates = 4000;
+    for (int batch : batches){
+        std::remove(snapshot.c_str());
+        std::remove(path.c_str());
+        Streak streak;
+        StreakJournal journal;
+        journal.recover(snapshot, path, streak, batch, 10000000);
+        auto startTime = chrono::steady_clock::now();
+        for (int i = 0; i < updates; i++){
+            int id = idGen.getRandNum();
+            if (streak.insert(Tiger(id)) != INSERTED){
+                streak.remove(id);
+            }
+        }
+        journal.sync();
+        double time = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+        cout << "journal batch " << batch << ": " << updates << " updates in " << time << " ms ("
+             << (long)(updates / time * 1000) << " updates/s, " << journal.syncs() << " fsyncs)" << endl;
+    }
+    std::remove(snapshot.c_str());
+    std::remove(path.c_str());
+}
@@ -0,0 +1,770 @@
+#include "optimisticstreak.h"
+
+// reads of a node's version while a rotation moves it, before the reader blocks on the node's lock
+const int SPINCOUNT = 100;
+
+OptimisticTiger::OptimisticTiger(int id, int attrs, OptimisticTiger *parent) : m_id(id){
+    m_attrs.store(attrs);
+    m_height.store(1);
+    m_version.store(0);
+    m_parent.store(parent);
+    m_left.store(nullptr);
+    m_right.store(nullptr);
+}
+
+OptimisticStreak::OptimisticStreak() : m_holder(DEFAULT_ID, ABSENT, nullptr){
+    for (int i = 0; i < 3; i++){
+        m_ages[i].store(0);
+        m_genders[i].store(0);
+    }
+    m_states[ALIVE].store(0);
+    m_states[DEAD].store(0);
+}
+
+// no thread can be inside any more, so every node goes at once
+OptimisticStreak::~OptimisticStreak(){
+    clear();
+    for (auto &retired : m_retired){
+        delete retired.second;
+    }
+}
+
+// checks if id is within MINID and MAXID, a routing node left by a remove takes the tiger back
+RESULT OptimisticStreak::insert(const Tiger& tiger){
+    if (tiger.getID() < MINID || tiger.getID() > MAXID){
+        return OUTOFRANGE;
+    }
+    int attrs = packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState());
+    if (update(tiger.getID(), INSERTIFABSENT, attrs) != ABSENT){
+        return DUPLICATE;
+    }
+    count(attrs, 1);
+    return INSERTED;
+}
+
+bool OptimisticStreak::remove(int id){
+    int attrs = update(id, REMOVE, 0);
+    if (attrs == ABSENT){
+        return false;
+    }
+    count(attrs, -1);
+    return true;
+}
+
+bool OptimisticStreak::setState(int id, STATE state){
+    int attrs = update(id, SETSTATE, state);
+    if (attrs == ABSENT){
+        return false;
+    }
+    count(attrs, -1);
+    count(next(SETSTATE, state, attrs), 1);
+    return true;
+}
+
+// collects the dead ids in one traversal, then removes each one that is still dead when its update gets there
+int OptimisticStreak::removeDead(){
+    vector<int> dead;
+    {
+        EpochDomain::Guard guard(m_epochs);
+        collectDead(m_holder.m_right.load(), dead);
+    }
+    int removed = 0;
+    for (int id : dead){
+        int attrs = update(id, REMOVEIFDEAD, 0);
+        if (attrs != ABSENT && unpackState(attrs) == DEAD){
+            count(attrs, -1);
+            removed++;
+        }
+    }
+    return removed;
+}
+
+bool OptimisticStreak::findTiger(int id) const{
+    return get(id) != ABSENT;
+}
+
+bool OptimisticStreak::getTiger(int id, Tiger &tiger) const{
+    int attrs = get(id);
+    if (attrs == ABSENT){
+        return false;
+    }
+    tiger = Tiger(id, unpackAge(attrs), unpackGender(attrs), unpackState(attrs));
+    return true;
+}
+
+int OptimisticStreak::countTigerCubs() const{
+    return countBy(CUB);
+}
+
+int OptimisticStreak::countBy(AGE age) const{
+    return m_ages[age].load();
+}
+
+int OptimisticStreak::countBy(GENDER gender) const{
+    return m_genders[gender].load();
+}
+
+int OptimisticStreak::countBy(STATE state) const{
+    return m_states[state].load();
+}
+
+int OptimisticStreak::size() const{
+    return m_states[ALIVE].load() + m_states[DEAD].load();
+}
+
+void OptimisticStreak::listTigers() const{
+    listTigers(m_holder.m_right.load());
+}
+
+void OptimisticStreak::clear(){
+    clear(m_holder.m_right.load());
+    m_holder.m_right.store(nullptr);
+    for (int i = 0; i < 3; i++){
+        m_ages[i].store(0);
+        m_genders[i].store(0);
+    }
+    m_states[ALIVE].store(0);
+    m_states[DEAD].store(0);
+}
+
+// the attributes of the tiger with this id, ABSENT if there is none. starts over whenever the root moved
+int OptimisticStreak::get(int id) const{
+    EpochDomain::Guard guard(m_epochs);
+    while (true){
+        OptimisticTiger *root = m_holder.m_right.load();
+        if (root == nullptr){
+            return ABSENT;
+        }
+        if (id == root->m_id){
+            return root->m_attrs.load();
+        }
+        uint64_t version = root->m_version.load();
+        if (version & (SHRINKING | UNLINKED)){
+            waitUntilNotChanging(root);
+        }else if (root == m_holder.m_right.load()){
+            int attrs = attemptGet(id, root, id < root->m_id ? -1 : 1, version);
+            if (attrs != RETRY){
+                return attrs;
+            }
+        }
+    }
+}
+
+// searches below node, which had nodeVersion when its link was followed. the child is only entered after node is
+// checked to still have that version, so the id can not have been moved out of the child's subtree in between. a
+// child that changes is retried from node, a node that changes makes the caller retry
+int OptimisticStreak::attemptGet(int id, OptimisticTiger *node, int direction, uint64_t nodeVersion) const{
+    while (true){
+        OptimisticTiger *child = node->child(direction).load();
+        if (child == nullptr){
+            if (node->m_version.load() != nodeVersion){
+                return RETRY;
+            }
+            return ABSENT;
+        }
+        if (id == child->m_id){
+            return child->m_attrs.load();
+        }
+        uint64_t childVersion = child->m_version.load();
+        if (childVersion & (SHRINKING | UNLINKED)){
+            waitUntilNotChanging(child);
+            if (node->m_version.load() != nodeVersion){
+                return RETRY;
+            }
+        }else if (child != node->child(direction).load()){
+            if (node->m_version.load() != nodeVersion){
+                return RETRY;
+            }
+        }else{
+            if (node->m_version.load() != nodeVersion){
+                return RETRY;
+            }
+            int attrs = attemptGet(id, child, id < child->m_id ? -1 : 1, childVersion);
+            if (attrs != RETRY){
+                return attrs;
+            }
+        }
+    }
+}
+
+// applies mode to the tiger with this id, or to the empty spot where it would go, and returns the attributes it had
+// before (ABSENT if there was none). the attributes after are next(mode, value, before)
+int OptimisticStreak::update(int id, UPDATE mode, int value){
+    EpochDomain::Guard guard(m_epochs);
+    while (true){
+        OptimisticTiger *root = m_holder.m_right.load();
+        if (root == nullptr){
+            int attrs = next(mode, value, ABSENT);
+            if (attrs == ABSENT){
+                return ABSENT;
+            }
+            lock_guard<mutex> lock(m_holder.m_lock);
+            if (m_holder.m_right.load() == nullptr){
+                m_holder.m_right.store(new OptimisticTiger(id, attrs, &m_holder));
+                return ABSENT;
+            }
+        }else{
+            uint64_t version = root->m_version.load();
+            if (version & (SHRINKING | UNLINKED)){
+                waitUntilNotChanging(root);
+            }else if (root == m_holder.m_right.load()){
+                int attrs = attemptUpdate(id, mode, value, &m_holder, root, version);
+                if (attrs != RETRY){
+                    return attrs;
+                }
+            }
+        }
+    }
+}
+
+// the same descent as attemptGet. a new leaf is linked under the lock of its parent, which must still have the
+// version the descent saw, and the heights it changed are fixed on the way back up
+int OptimisticStreak::attemptUpdate(int id, UPDATE mode, int value, OptimisticTiger *parent, OptimisticTiger *node,
+                                    uint64_t nodeVersion){
+    if (id == node->m_id){
+        return attemptNodeUpdate(mode, value, parent, node);
+    }
+    int direction = id < node->m_id ? -1 : 1;
+    while (true){
+        OptimisticTiger *child = node->child(direction).load();
+        if (node->m_version.load() != nodeVersion){
+            return RETRY;
+        }
+        if (child == nullptr){
+            int attrs = next(mode, value, ABSENT);
+            if (attrs == ABSENT){
+                return ABSENT;
+            }
+            OptimisticTiger *damaged = nullptr;
+            bool linked = false;
+            {
+                lock_guard<mutex> lock(node->m_lock);
+                if (node->m_version.load() != nodeVersion){
+                    return RETRY;
+                }
+                // another insert got there first, the loop goes down to it
+                if (node->child(direction).load() == nullptr){
+                    node->child(direction).store(new OptimisticTiger(id, attrs, node));
+                    linked = true;
+                    damaged = fixHeight(node);
+                }
+            }
+            if (linked){
+                fixHeightAndRebalance(damaged);
+                return ABSENT;
+            }
+        }else{
+            uint64_t childVersion = child->m_version.load();
+            if (childVersion & (SHRINKING | UNLINKED)){
+                waitUntilNotChanging(child);
+            }else if (child == node->child(direction).load()){
+                if (node->m_version.load() != nodeVersion){
+                    return RETRY;
+                }
+                int attrs = attemptUpdate(id, mode, value, node, child, childVersion);
+                if (attrs != RETRY){
+                    return attrs;
+                }
+            }
+        }
+    }
+}
+
+// updates the tiger in node. a removal from a node with at most one child splices the node out, which needs the
+// parent's lock before the node's. a removal from a node with two children only clears the tiger and leaves a
+// routing node
+int OptimisticStreak::attemptNodeUpdate(UPDATE mode, int value, OptimisticTiger *parent, OptimisticTiger *node){
+    int before = node->m_attrs.load();
+    int after = next(mode, value, before);
+    if (after == before){
+        return before;
+    }
+    if (after == ABSENT && (node->m_left.load() == nullptr || node->m_right.load() == nullptr)){
+        OptimisticTiger *damaged;
+        {
+            lock_guard<mutex> parentLock(parent->m_lock);
+            if ((parent->m_version.load() & UNLINKED) || node->m_parent.load() != parent){
+                return RETRY;
+            }
+            {
+                lock_guard<mutex> lock(node->m_lock);
+                before = node->m_attrs.load();
+                // only a removal can change a tiger into ABSENT, so anything else left nothing to do
+                if (next(mode, value, before) == before){
+                    return before;
+                }
+                if (!attemptUnlink(parent, node)){
+                    return RETRY;
+                }
+            }
+            damaged = fixHeight(parent);
+        }
+        fixHeightAndRebalance(damaged);
+        return before;
+    }
+    lock_guard<mutex> lock(node->m_lock);
+    if (node->m_version.load() & UNLINKED){
+        return RETRY;
+    }
+    before = node->m_attrs.load();
+    after = next(mode, value, before);
+    if (after == before){
+        return before;
+    }
+    // the node lost a child since, it has to be spliced out instead
+    if (after == ABSENT && (node->m_left.load() == nullptr || node->m_right.load() == nullptr)){
+        return RETRY;
+    }
+    node->m_attrs.store(after);
+    return before;
+}
+
+// the attributes an update leaves in place of attrs
+int OptimisticStreak::next(UPDATE mode, int value, int attrs){
+    switch (mode){
+        case INSERTIFABSENT:
+            return attrs == ABSENT ? value : attrs;
+        case REMOVE:
+            return ABSENT;
+        case REMOVEIFDEAD:
+            return attrs != ABSENT && unpackState(attrs) == DEAD ? ABSENT : attrs;
+        case SETSTATE:
+            return attrs == ABSENT ? ABSENT : packAttrs(unpackAge(attrs), unpackGender(attrs), static_cast<STATE>(value));
+    }
+    return attrs;
+}
+
+// adds delta to the counts of a tiger with these attributes
+void OptimisticStreak::count(int attrs, int delta){
+    m_ages[unpackAge(attrs)].fetch_add(delta, memory_order_relaxed);
+    m_genders[unpackGender(attrs)].fetch_add(delta, memory_order_relaxed);
+    m_states[unpackState(attrs)].fetch_add(delta, memory_order_relaxed);
+}
+
+// splices out a node with at most one child, both locked by the caller. returns false if the node is no longer a
+// child of parent or got a second child
+bool OptimisticStreak::attemptUnlink(OptimisticTiger *parent, OptimisticTiger *node){
+    OptimisticTiger *parentLeft = parent->m_left.load();
+    OptimisticTiger *parentRight = parent->m_right.load();
+    if (parentLeft != node && parentRight != node){
+        return false;
+    }
+    OptimisticTiger *left = node->m_left.load();
+    OptimisticTiger *right = node->m_right.load();
+    if (left != nullptr && right != nullptr){
+        return false;
+    }
+    OptimisticTiger *splice = left != nullptr ? left : right;
+    if (parentLeft == node){
+        parent->m_left.store(splice);
+    }else{
+        parent->m_right.store(splice);
+    }
+    if (splice != nullptr){
+        splice->m_parent.store(parent);
+    }
+    node->m_version.store(UNLINKED);
+    node->m_attrs.store(ABSENT);
+    retire(node);
+    return true;
+}
+
+// tags a node that left the tree with the epoch that ends now, and frees the ones no thread can see any more
+void OptimisticStreak::retire(OptimisticTiger *node){
+    lock_guard<mutex> lock(m_retiredLock);
+    m_retired.push_back({m_epochs.advance(), node});
+    if (m_retired.size() >= RECLAIMBATCH){
+        uint64_t oldest = m_epochs.oldest();
+        size_t kept = 0;
+        for (size_t i = 0; i < m_retired.size(); i++){
+            if (m_retired[i].first < oldest){
+                delete m_retired[i].second;
+            }else{
+                m_retired[kept++] = m_retired[i];
+            }
+        }
+        m_retired.resize(kept);
+    }
+}
+
+// a rotation holds the node's lock while it is shrinking, so after a short spin the lock is the way to wait
+void OptimisticStreak::waitUntilNotChanging(OptimisticTiger *node){
+    uint64_t version = node->m_version.load();
+    if (version & SHRINKING){
+        for (int i = 0; i < SPINCOUNT; i++){
+            if (node->m_version.load() != version){
+                return;
+            }
+        }
+        lock_guard<mutex> lock(node->m_lock);
+    }
+}
+
+// the height of a subtree, 0 for an empty one
+int OptimisticStreak::height(OptimisticTiger *node){
+    return node == nullptr ? 0 : node->m_height.load();
+}
+
+// what a node needs: to be spliced out (a routing node with at most one child), a rotation, a new height (returned),
+// or nothing
+int OptimisticStreak::nodeCondition(OptimisticTiger *node){
+    OptimisticTiger *left = node->m_left.load();
+    OptimisticTiger *right = node->m_right.load();
+    if ((left == nullptr || right == nullptr) && node->m_attrs.load() == ABSENT){
+        return UNLINKREQUIRED;
+    }
+    int hN = node->m_height.load();
+    int hL0 = height(left);
+    int hR0 = height(right);
+    int hNRepl = 1 + max(hL0, hR0);
+    int balance = hL0 - hR0;
+    if (balance < -1 || balance > 1){
+        return REBALANCEREQUIRED;
+    }
+    return hN != hNRepl ? hNRepl : NOTHINGREQUIRED;
+}
+
+// fixes the height of a locked node if that is all it needs. returns the next node to look at: the parent after a
+// height change, the node itself if it needs more, nullptr if it was fine
+OptimisticTiger *OptimisticStreak::fixHeight(OptimisticTiger *node){
+    int condition = nodeCondition(node);
+    if (condition == REBALANCEREQUIRED || condition == UNLINKREQUIRED){
+        return node;
+    }
+    if (condition == NOTHINGREQUIRED){
+        return nullptr;
+    }
+    node->m_height.store(condition);
+    return node->m_parent.load();
+}
+
+// repairs from a damaged node up until nothing is left to fix. a rebalance locks the parent and then the node
+void OptimisticStreak::fixHeightAndRebalance(OptimisticTiger *node){
+    while (node != nullptr && node->m_parent.load() != nullptr){
+        int condition = nodeCondition(node);
+        if (condition == NOTHINGREQUIRED || (node->m_version.load() & UNLINKED)){
+            return;
+        }
+        if (condition != UNLINKREQUIRED && condition != REBALANCEREQUIRED){
+            lock_guard<mutex> lock(node->m_lock);
+            node = fixHeight(node);
+        }else{
+            OptimisticTiger *parent = node->m_parent.load();
+            lock_guard<mutex> parentLock(parent->m_lock);
+            if (!(parent->m_version.load() & UNLINKED) && node->m_parent.load() == parent){
+                lock_guard<mutex> lock(node->m_lock);
+                node = rebalance(parent, node);
+            }
+        }
+    }
+}
+
+// parent and node are locked. splices out a routing node with at most one child, rotates an imbalanced node or fixes
+// its height, and returns the next damaged node
+OptimisticTiger *OptimisticStreak::rebalance(OptimisticTiger *parent, OptimisticTiger *node){
+    OptimisticTiger *left = node->m_left.load();
+    OptimisticTiger *right = node->m_right.load();
+    if ((left == nullptr || right == nullptr) && node->m_attrs.load() == ABSENT){
+        if (attemptUnlink(parent, node)){
+            // a rotation that left node to be spliced out did not fix the height above parent, so that is looked at
+            // even if parent's height stays
+            OptimisticTiger *damaged = fixHeight(parent);
+            return damaged != nullptr ? damaged : parent->m_parent.load();
+        }
+        return node;
+    }
+    int hN = node->m_height.load();
+    int hL0 = height(left);
+    int hR0 = height(right);
+    int hNRepl = 1 + max(hL0, hR0);
+    int balance = hL0 - hR0;
+    if (balance > 1){
+        return rebalanceToRight(parent, node, left, hR0);
+    }else if (balance < -1){
+        return rebalanceToLeft(parent, node, right, hL0);
+    }else if (hNRepl != hN){
+        node->m_height.store(hNRepl);
+        return fixHeight(parent);
+    }
+    return nullptr;
+}
+
+// node leans left. locks the left child, and its right child too if the left child leans right. a double rotation
+// that would leave the left child imbalanced (only possible while other updates run) is done as a rotation of the left
+// child first
+OptimisticTiger *OptimisticStreak::rebalanceToRight(OptimisticTiger *parent, OptimisticTiger *node,
+                                                    OptimisticTiger *left, int hR0){
+    lock_guard<mutex> lock(left->m_lock);
+    int hL = left->m_height.load();
+    if (hL - hR0 <= 1){
+        return node;
+    }
+    OptimisticTiger *inner = left->m_right.load();
+    int hLL0 = height(left->m_left.load());
+    int hLR0 = height(inner);
+    if (hLL0 >= hLR0){
+        return singleRight(parent, node, left, hR0, hLL0, inner, hLR0);
+    }
+    {
+        lock_guard<mutex> innerLock(inner->m_lock);
+        int hLR = inner->m_height.load();
+        if (hLL0 >= hLR){
+            return singleRight(parent, node, left, hR0, hLL0, inner, hLR);
+        }
+        int hLRL = height(inner->m_left.load());
+        int balance = hLL0 - hLRL;
+        if (balance >= -1 && balance <= 1){
+            return leftRight(parent, node, left, hR0, hLL0, inner, hLRL);
+        }
+    }
+    return rebalanceToLeft(node, left, inner, hLL0);
+}
+
+// mirror of rebalanceToRight
+OptimisticTiger *OptimisticStreak::rebalanceToLeft(OptimisticTiger *parent, OptimisticTiger *node,
+                                                   OptimisticTiger *right, int hL0){
+    lock_guard<mutex> lock(right->m_lock);
+    int hR = right->m_height.load();
+    if (hL0 - hR >= -1){
+        return node;
+    }
+    OptimisticTiger *inner = right->m_left.load();
+    int hRL0 = height(inner);
+    int hRR0 = height(right->m_right.load());
+    if (hRR0 >= hRL0){
+        return singleLeft(parent, node, right, hL0, hRR0, inner, hRL0);
+    }
+    {
+        lock_guard<mutex> innerLock(inner->m_lock);
+        int hRL = inner->m_height.load();
+        if (hRR0 >= hRL){
+            return singleLeft(parent, node, right, hL0, hRR0, inner, hRL);
+        }
+        int hRLR = height(inner->m_right.load());
+        int balance = hRR0 - hRLR;
+        if (balance >= -1 && balance <= 1){
+            return rightLeft(parent, node, right, hL0, hRR0, inner, hRLR);
+        }
+    }
+    return rebalanceToRight(node, right, inner, hRR0);
+}
+
+// single right rotation, parent, node and left are locked. node moves down and loses keys, so its version is marked
+// shrinking while the links change and counted up after. returns the next damaged node
+OptimisticTiger *OptimisticStreak::singleRight(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *left,
+                                               int hR, int hLL, OptimisticTiger *inner, int hLR){
+    uint64_t version = node->m_version.load();
+    OptimisticTiger *parentLeft = parent->m_left.load();
+    node->m_version.store(version | SHRINKING);
+    node->m_left.store(inner);
+    if (inner != nullptr){
+        inner->m_parent.store(node);
+    }
+    left->m_right.store(node);
+    node->m_parent.store(left);
+    if (parentLeft == node){
+        parent->m_left.store(left);
+    }else{
+        parent->m_right.store(left);
+    }
+    left->m_parent.store(parent);
+    int hNRepl = 1 + max(hLR, hR);
+    node->m_height.store(hNRepl);
+    left->m_height.store(1 + max(hLL, hNRepl));
+    node->m_version.store(version + SHRINKCOUNT);
+    int balanceN = hLR - hR;
+    if (balanceN < -1 || balanceN > 1){
+        return node;
+    }
+    if ((inner == nullptr || hR == 0) && node->m_attrs.load() == ABSENT){
+        return node;
+    }
+    int balanceL = hLL - hNRepl;
+    if (balanceL < -1 || balanceL > 1){
+        return left;
+    }
+    if (hLL == 0 && left->m_attrs.load() == ABSENT){
+        return left;
+    }
+    return fixHeight(parent);
+}
+
+// single left rotation, mirror of singleRight
+OptimisticTiger *OptimisticStreak::singleLeft(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *right,
+                                              int hL, int hRR, OptimisticTiger *inner, int hRL){
+    uint64_t version = node->m_version.load();
+    OptimisticTiger *parentLeft = parent->m_left.load();
+    node->m_version.store(version | SHRINKING);
+    node->m_right.store(inner);
+    if (inner != nullptr){
+        inner->m_parent.store(node);
+    }
+    right->m_left.store(node);
+    node->m_parent.store(right);
+    if (parentLeft == node){
+        parent->m_left.store(right);
+    }else{
+        parent->m_right.store(right);
+    }
+    right->m_parent.store(parent);
+    int hNRepl = 1 + max(hL, hRL);
+    node->m_height.store(hNRepl);
+    right->m_height.store(1 + max(hNRepl, hRR));
+    node->m_version.store(version + SHRINKCOUNT);
+    int balanceN = hRL - hL;
+    if (balanceN < -1 || balanceN > 1){
+        return node;
+    }
+    if ((inner == nullptr || hL == 0) && node->m_attrs.load() == ABSENT){
+        return node;
+    }
+    int balanceR = hRR - hNRepl;
+    if (balanceR < -1 || balanceR > 1){
+        return right;
+    }
+    if (hRR == 0 && right->m_attrs.load() == ABSENT){
+        return right;
+    }
+    return fixHeight(parent);
+}
+
+// double left right rotation, parent, node, left and inner (left's right child) are locked. inner comes up over
+// both, and node and left move down. a routing node that is left with one child is returned to be spliced out
+OptimisticTiger *OptimisticStreak::leftRight(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *left,
+                                             int hR, int hLL, OptimisticTiger *inner, int hLRL){
+    uint64_t nodeVersion = node->m_version.load();
+    uint64_t leftVersion = left->m_version.load();
+    OptimisticTiger *parentLeft = parent->m_left.load();
+    OptimisticTiger *innerLeft = inner->m_left.load();
+    OptimisticTiger *innerRight = inner->m_right.load();
+    int hLRR = height(innerRight);
+    node->m_version.store(nodeVersion | SHRINKING);
+    left->m_version.store(leftVersion | SHRINKING);
+    node->m_left.store(innerRight);
+    if (innerRight != nullptr){
+        innerRight->m_parent.store(node);
+    }
+    left->m_right.store(innerLeft);
+    if (innerLeft != nullptr){
+        innerLeft->m_parent.store(left);
+    }
+    inner->m_left.store(left);
+    left->m_parent.store(inner);
+    inner->m_right.store(node);
+    node->m_parent.store(inner);
+    if (parentLeft == node){
+        parent->m_left.store(inner);
+    }else{
+        parent->m_right.store(inner);
+    }
+    inner->m_parent.store(parent);
+    int hNRepl = 1 + max(hLRR, hR);
+    node->m_height.store(hNRepl);
+    int hLRepl = 1 + max(hLL, hLRL);
+    left->m_height.store(hLRepl);
+    inner->m_height.store(1 + max(hLRepl, hNRepl));
+    node->m_version.store(nodeVersion + SHRINKCOUNT);
+    left->m_version.store(leftVersion + SHRINKCOUNT);
+    int balanceN = hLRR - hR;
+    if (balanceN < -1 || balanceN > 1){
+        return node;
+    }
+    if ((innerRight == nullptr || hR == 0) && node->m_attrs.load() == ABSENT){
+        return node;
+    }
+    if ((innerLeft == nullptr || hLL == 0) && left->m_attrs.load() == ABSENT){
+        return left;
+    }
+    int balanceLR = hLRepl - hNRepl;
+    if (balanceLR < -1 || balanceLR > 1){
+        return inner;
+    }
+    return fixHeight(parent);
+}
+
+// double right left rotation, mirror of leftRight
+OptimisticTiger *OptimisticStreak::rightLeft(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *right,
+                                             int hL, int hRR, OptimisticTiger *inner, int hRLR){
+    uint64_t nodeVersion = node->m_version.load();
+    uint64_t rightVersion = right->m_version.load();
+    OptimisticTiger *parentLeft = parent->m_left.load();
+    OptimisticTiger *innerLeft = inner->m_left.load();
+    OptimisticTiger *innerRight = inner->m_right.load();
+    int hRLL = height(innerLeft);
+    node->m_version.store(nodeVersion | SHRINKING);
+    right->m_version.store(rightVersion | SHRINKING);
+    node->m_right.store(innerLeft);
+    if (innerLeft != nullptr){
+        innerLeft->m_parent.store(node);
+    }
+    right->m_left.store(innerRight);
+    if (innerRight != nullptr){
+        innerRight->m_parent.store(right);
+    }
+    inner->m_right.store(right);
+    right->m_parent.store(inner);
+    inner->m_left.store(node);
+    node->m_parent.store(inner);
+    if (parentLeft == node){
+        parent->m_left.store(inner);
+    }else{
+        parent->m_right.store(inner);
+    }
+    inner->m_parent.store(parent);
+    int hNRepl = 1 + max(hL, hRLL);
+    node->m_height.store(hNRepl);
+    int hRRepl = 1 + max(hRLR, hRR);
+    right->m_height.store(hRRepl);
+    inner->m_height.store(1 + max(hNRepl, hRRepl));
+    node->m_version.store(nodeVersion + SHRINKCOUNT);
+    right->m_version.store(rightVersion + SHRINKCOUNT);
+    int balanceN = hRLL - hL;
+    if (balanceN < -1 || balanceN > 1){
+        return node;
+    }
+    if ((innerLeft == nullptr || hL == 0) && node->m_attrs.load() == ABSENT){
+        return node;
+    }
+    if ((innerRight == nullptr || hRR == 0) && right->m_attrs.load() == ABSENT){
+        return right;
+    }
+    int balanceRL = hRRepl - hNRepl;
+    if (balanceRL < -1 || balanceRL > 1){
+        return inner;
+    }
+    return fixHeight(parent);
+}
+
+// in order traversal that appends the ids of dead tigers to dead, routing nodes are skipped
+void OptimisticStreak::collectDead(OptimisticTiger *node, vector<int> &dead) const{
+    if (node != nullptr){
+        collectDead(node->m_left.load(), dead);
+        int attrs = node->m_attrs.load();
+        if (attrs != ABSENT && unpackState(attrs) == DEAD){
+            dead.push_back(node->m_id);
+        }
+        collectDead(node->m_right.load(), dead);
+    }
+}
+
+// lists tigers and their elements in the same format as Streak, in order traversal
+void OptimisticStreak::listTigers(OptimisticTiger *node) const{
+    if (node != nullptr){
+        listTigers(node->m_left.load());
+        int attrs = node->m_attrs.load();
+        if (attrs != ABSENT){
+            Tiger tiger(node->m_id, unpackAge(attrs), unpackGender(attrs), unpackState(attrs));
+            cout << tiger.getID() << ":" << tiger.getAgeStr() << ":" << tiger.getGenderStr() << ":"
+            << tiger.getStateStr() << endl;
+        }
+        listTigers(node->m_right.load());
+    }
+}
+
+void OptimisticStreak::clear(OptimisticTiger *node){
+    if (node != nullptr){
+        clear(node->m_left.load());
+        clear(node->m_right.load());
+        delete node;
+    }
+}
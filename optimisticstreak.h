@@ -0,0 +1,110 @@
+#ifndef OPTIMISTICSTREAK_H
+#define OPTIMISTICSTREAK_H
+#include "streak.h"
+#include "epoch.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+// a node of OptimisticStreak. every field but the id can change while other threads read it, so they are atomic, and
+// m_lock is held by whoever changes the node's links or tiger. m_version changes whenever the node loses keys from its
+// subtree (a rotation moves it down) or leaves the tree, a reader that saw it change has to retry from the parent
+struct OptimisticTiger{
+    OptimisticTiger(int id, int attrs, OptimisticTiger *parent);
+    const int m_id;
+    atomic<int> m_attrs;//packed age | gender << 2 | state << 4, ABSENT if the tiger was removed but the node still routes
+    atomic<int> m_height;//1 for a leaf, 0 for an empty subtree, may be off while an update is still being fixed
+    atomic<uint64_t> m_version;//UNLINKED and SHRINKING bits, then a count of the rotations that moved the node down
+    atomic<OptimisticTiger*> m_parent;
+    atomic<OptimisticTiger*> m_left;
+    atomic<OptimisticTiger*> m_right;
+    mutex m_lock;
+    atomic<OptimisticTiger*> &child(int direction){
+        return direction < 0 ? m_left : m_right;
+    }
+};
+
+// the Streak API for many writer threads, after Bronson, Casper, Chafi and Olukotun's optimistic concurrent AVL
+// tree. lookups take no lock: they check the version of every node they pass and retry from the last node that did
+// not change. writers lock only the nodes they change, a parent before its child: an insert locks the parent of the
+// new leaf, a state change the tiger's node, and a rotation the nodes it moves. a removed tiger whose node has two
+// children stays as a routing node until the node can be spliced out. balance is relaxed while updates run and
+// restored by the thread that broke it before its update returns. the counts are kept for the whole streak, exact
+// whenever no update is running. nodes that leave the tree are freed by epoch based reclamation
+class OptimisticStreak{
+public:
+    friend class Tester;
+    OptimisticStreak();
+    ~OptimisticStreak();
+    OptimisticStreak(const OptimisticStreak&) = delete;
+    OptimisticStreak &operator=(const OptimisticStreak&) = delete;
+    // safe from any thread at any time
+    RESULT insert(const Tiger& tiger);
+    bool remove(int id);// returns false if the id is not in the tree
+    bool setState(int id, STATE state);
+    // removes the tigers that are dead when it reaches them, returns how many it removed. tigers that die while it
+    // runs may stay
+    int removeDead();
+    bool findTiger(int id) const;//returns true if the tiger is in tree
+    bool getTiger(int id, Tiger &tiger) const;//copies the tiger with this id into tiger, returns false if there is none
+    int countTigerCubs() const;// returns the # of cubs in the streak
+    int countBy(AGE age) const;
+    int countBy(GENDER gender) const;
+    int countBy(STATE state) const;
+    int size() const;
+    // only while no other thread uses the streak
+    void listTigers() const;
+    void clear();
+private:
+    // what an update does with the tiger it finds, or with the empty spot where the id would go
+    enum UPDATE {INSERTIFABSENT, REMOVE, REMOVEIFDEAD, SETSTATE};
+    static const int ABSENT = -1;//no tiger in the node, or no node
+    static const int RETRY = -2;//a node on the way changed, the caller starts again from its own node
+    // nodeCondition results, any other value is the height the node should have
+    static const int UNLINKREQUIRED = -1;
+    static const int REBALANCEREQUIRED = -2;
+    static const int NOTHINGREQUIRED = -3;
+    static const uint64_t UNLINKED = 1;
+    static const uint64_t SHRINKING = 2;
+    static const uint64_t SHRINKCOUNT = 4;
+
+    OptimisticTiger m_holder;//sentinel above the root, the root is its right child
+    mutable EpochDomain m_epochs;
+    atomic<int> m_ages[3];//number of tigers of each AGE in the streak
+    atomic<int> m_genders[3];//number of tigers of each GENDER in the streak
+    atomic<int> m_states[2];//number of tigers of each STATE in the streak
+    mutex m_retiredLock;
+    vector<pair<uint64_t, OptimisticTiger*>> m_retired;//nodes out of the tree, with the epoch they were retired in
+
+    int get(int id) const;
+    int attemptGet(int id, OptimisticTiger *node, int direction, uint64_t nodeVersion) const;
+    int update(int id, UPDATE mode, int value);
+    int attemptUpdate(int id, UPDATE mode, int value, OptimisticTiger *parent, OptimisticTiger *node,
+                      uint64_t nodeVersion);
+    int attemptNodeUpdate(UPDATE mode, int value, OptimisticTiger *parent, OptimisticTiger *node);
+    static int next(UPDATE mode, int value, int attrs);
+    void count(int attrs, int delta);
+    bool attemptUnlink(OptimisticTiger *parent, OptimisticTiger *node);
+    void retire(OptimisticTiger *node);
+    static void waitUntilNotChanging(OptimisticTiger *node);
+    static int height(OptimisticTiger *node);
+    static int nodeCondition(OptimisticTiger *node);
+    static OptimisticTiger *fixHeight(OptimisticTiger *node);
+    void fixHeightAndRebalance(OptimisticTiger *node);
+    OptimisticTiger *rebalance(OptimisticTiger *parent, OptimisticTiger *node);
+    OptimisticTiger *rebalanceToRight(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *left, int hR0);
+    OptimisticTiger *rebalanceToLeft(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *right, int hL0);
+    static OptimisticTiger *singleRight(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *left, int hR,
+                                        int hLL, OptimisticTiger *inner, int hLR);
+    static OptimisticTiger *singleLeft(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *right, int hL,
+                                       int hRR, OptimisticTiger *inner, int hRL);
+    static OptimisticTiger *leftRight(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *left, int hR,
+                                      int hLL, OptimisticTiger *inner, int hLRL);
+    static OptimisticTiger *rightLeft(OptimisticTiger *parent, OptimisticTiger *node, OptimisticTiger *right, int hL,
+                                      int hRR, OptimisticTiger *inner, int hRLR);
+    void collectDead(OptimisticTiger *node, vector<int> &dead) const;
+    void listTigers(OptimisticTiger *node) const;
+    void clear(OptimisticTiger *node);
+};
+#endif
@@ -0,0 +1,185 @@
+#include "shardedstreak.h"
+#include "taskpool.h"
+#include <mutex>
+
+// cuts MINID..MAXID into shards ranges, rounding the width up so the last range ends at MAXID or before
+ShardedStreak::ShardedStreak(int shards){
+    const int ids = MAXID - MINID + 1;
+    m_count = max(1, min(shards, ids));
+    m_width = (ids + m_count - 1) / m_count;
+    m_shards.reset(new StreakShard[m_count]);
+}
+
+// out of range ids are turned away before any lock is taken
+RESULT ShardedStreak::insert(const Tiger& tiger){
+    if (tiger.getID() < MINID || tiger.getID() > MAXID){
+        return OUTOFRANGE;
+    }
+    StreakShard &shard = m_shards[shardOf(tiger.getID())];
+    unique_lock<shared_mutex> lock(shard.m_lock);
+    return shard.m_streak.insert(tiger);
+}
+
+bool ShardedStreak::remove(int id){
+    if (id < MINID || id > MAXID){
+        return false;
+    }
+    StreakShard &shard = m_shards[shardOf(id)];
+    unique_lock<shared_mutex> lock(shard.m_lock);
+    return shard.m_streak.remove(id);
+}
+
+bool ShardedStreak::setState(int id, STATE state){
+    if (id < MINID || id > MAXID){
+        return false;
+    }
+    StreakShard &shard = m_shards[shardOf(id)];
+    unique_lock<shared_mutex> lock(shard.m_lock);
+    return shard.m_streak.setState(id, state);
+}
+
+bool ShardedStreak::findTiger(int id) const{
+    if (id < MINID || id > MAXID){
+        return false;
+    }
+    const StreakShard &shard = m_shards[shardOf(id)];
+    shared_lock<shared_mutex> lock(shard.m_lock);
+    return shard.m_streak.findTiger(id);
+}
+
+int ShardedStreak::countTigerCubs() const{
+    return sum([](const Streak &streak){return streak.countTigerCubs();});
+}
+
+int ShardedStreak::countBy(AGE age) const{
+    return sum([age](const Streak &streak){return streak.countBy(age);});
+}
+
+int ShardedStreak::countBy(GENDER gender) const{
+    return sum([gender](const Streak &streak){return streak.countBy(gender);});
+}
+
+int ShardedStreak::countBy(STATE state) const{
+    return sum([state](const Streak &streak){return streak.countBy(state);});
+}
+
+int ShardedStreak::size() const{
+    return sum([](const Streak &streak){return streak.size();});
+}
+
+// the shards hold increasing id ranges, so listing them one after the other keeps the ids in order
+void ShardedStreak::listTigers() const{
+    for (int i = 0; i < m_count; i++){
+        shared_lock<shared_mutex> lock(m_shards[i].m_lock);
+        m_shards[i].m_streak.listTigers();
+    }
+}
+
+void ShardedStreak::clear(){
+    for (int i = 0; i < m_count; i++){
+        unique_lock<shared_mutex> lock(m_shards[i].m_lock);
+        m_shards[i].m_streak.clear();
+    }
+}
+
+int ShardedStreak::removeDead(){
+    int removed = 0;
+    for (int i = 0; i < m_count; i++){
+        unique_lock<shared_mutex> lock(m_shards[i].m_lock);
+        removed += m_shards[i].m_streak.removeDead();
+    }
+    return removed;
+}
+
+// forks a task for every shard but the first, which the calling thread does before it waits for the rest
+int ShardedStreak::removeDead(TaskPool& tasks){
+    vector<int> removed(m_count, 0);
+    unique_ptr<TaskPool::Task[]> work(new TaskPool::Task[m_count]);
+    for (int i = 0; i < m_count; i++){
+        work[i].m_work = [this, &removed, i]{
+            unique_lock<shared_mutex> lock(m_shards[i].m_lock);
+            removed[i] = m_shards[i].m_streak.removeDead();
+        };
+    }
+    for (int i = 1; i < m_count; i++){
+        tasks.fork(work[i]);
+    }
+    work[0].m_work();
+    int total = removed[0];
+    for (int i = 1; i < m_count; i++){
+        tasks.wait(work[i]);
+        total += removed[i];
+    }
+    return total;
+}
+
+int ShardedStreak::insertBatch(const vector<Tiger>& tigers){
+    vector<vector<Tiger>> batches = partition(tigers);
+    int inserted = 0;
+    for (int i = 0; i < m_count; i++){
+        if (!batches[i].empty()){
+            unique_lock<shared_mutex> lock(m_shards[i].m_lock);
+            inserted += m_shards[i].m_streak.insertBatch(batches[i]);
+        }
+    }
+    return inserted;
+}
+
+// like removeDead(TaskPool&), shards the batch has no tigers for are not locked at all
+int ShardedStreak::insertBatch(const vector<Tiger>& tigers, TaskPool& tasks){
+    vector<vector<Tiger>> batches = partition(tigers);
+    vector<int> inserted(m_count, 0);
+    unique_ptr<TaskPool::Task[]> work(new TaskPool::Task[m_count]);
+    for (int i = 0; i < m_count; i++){
+        work[i].m_work = [this, &batches, &inserted, i]{
+            if (!batches[i].empty()){
+                unique_lock<shared_mutex> lock(m_shards[i].m_lock);
+                inserted[i] = m_shards[i].m_streak.insertBatch(batches[i]);
+            }
+        };
+    }
+    for (int i = 1; i < m_count; i++){
+        tasks.fork(work[i]);
+    }
+    work[0].m_work();
+    int total = inserted[0];
+    for (int i = 1; i < m_count; i++){
+        tasks.wait(work[i]);
+        total += inserted[i];
+    }
+    return total;
+}
+
+int ShardedStreak::shards() const{
+    return m_count;
+}
+
+int ShardedStreak::shardOf(int id) const{
+    return (id - MINID) / m_width;
+}
+
+// holds every shard shared at once, so the total is the state of the whole streak at the moment the last lock was
+// taken. writers only ever hold one shard, so waiting for them with the others held can not deadlock
+template <class Count>
+int ShardedStreak::sum(Count count) const{
+    vector<shared_lock<shared_mutex>> locks;
+    locks.reserve(m_count);
+    int total = 0;
+    for (int i = 0; i < m_count; i++){
+        locks.emplace_back(m_shards[i].m_lock);
+        total += count(m_shards[i].m_streak);
+    }
+    return total;
+}
+
+// splits a batch by shard, keeping the order of the tigers so the first of several with the same id still wins. out of
+// range ids are dropped, as insertBatch would
+vector<vector<Tiger>> ShardedStreak::partition(const vector<Tiger>& tigers) const{
+    vector<vector<Tiger>> batches(m_count);
+    for (const Tiger &tiger : tigers){
+        if (tiger.getID() >= MINID && tiger.getID() <= MAXID){
+            batches[shardOf(tiger.getID())].push_back(tiger);
+        }
+    }
+    return batches;
+}
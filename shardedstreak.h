@@ -0,0 +1,61 @@
+#ifndef SHARDEDSTREAK_H
+#define SHARDEDSTREAK_H
+#include "streak.h"
+#include <shared_mutex>
+#include <memory>
+#include <vector>
+
+class TaskPool;
+
+// the number of shards a ShardedStreak splits the id range into unless told otherwise
+const int SHARDS = 16;
+
+// one contiguous id range of a ShardedStreak. lookups and counts take the lock shared, updates take it alone. one
+// shard per cache line, so threads on neighbouring shards do not bounce each other's lock
+struct alignas(64) StreakShard{
+    Streak m_streak;
+    mutable shared_mutex m_lock;
+};
+
+// the Streak API for many writer threads, split by id: MINID..MAXID is cut into contiguous ranges of the same width,
+// and every range is a Streak with its own reader-writer lock. an operation on one id locks only the shard the id
+// falls in, so updates on different shards run side by side. updates that all hit one range still take turns, like a
+// Streak behind a mutex. the counts lock every shard shared in increasing order and are exact at one point in time.
+// listTigers and removeDead go shard by shard, and removeDead and insertBatch can hand one shard to each thread of a
+// TaskPool
+class ShardedStreak{
+public:
+    friend class Tester;
+    explicit ShardedStreak(int shards = SHARDS);
+    ShardedStreak(const ShardedStreak&) = delete;
+    ShardedStreak &operator=(const ShardedStreak&) = delete;
+    // safe from any thread at any time
+    RESULT insert(const Tiger& tiger);
+    bool remove(int id);// returns false if the id is not in the tree
+    bool setState(int id, STATE state);
+    bool findTiger(int id) const;//returns true if the tiger is in tree
+    int countTigerCubs() const;// returns the # of cubs in the streak, O(shards)
+    int countBy(AGE age) const;
+    int countBy(GENDER gender) const;
+    int countBy(STATE state) const;
+    int size() const;
+    // whole roster operations, a shard at a time. each shard is changed at once, but other threads can see the shards
+    // before and after it in different states
+    void listTigers() const;// every tiger in increasing id order
+    void clear();
+    int removeDead();//remove all dead tigers from the tree, returns how many were removed
+    int removeDead(TaskPool& tasks);// the same with every shard as its own task
+    int insertBatch(const vector<Tiger>& tigers);// same rules as insert, returns the # of tigers inserted
+    int insertBatch(const vector<Tiger>& tigers, TaskPool& tasks);
+    int shards() const;// returns the # of shards
+    int shardOf(int id) const;// returns the shard an id in range falls in
+private:
+    int m_count;//number of shards
+    int m_width;//number of ids per shard, the last one may have fewer
+    unique_ptr<StreakShard[]> m_shards;
+
+    template <class Count>
+    int sum(Count count) const;
+    vector<vector<Tiger>> partition(const vector<Tiger>& tigers) const;
+};
+#endif
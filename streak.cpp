@@ -1,129 +1,291 @@
 #include "streak.h"
+#include "taskpool.h"
+#include "streakview.h"
+#include "mappedstreak.h"
+#include "journal.h"
+#include <new>
+#include <fstream>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+TigerPool::TigerPool(){
+    m_first = nullptr;
+    m_current = nullptr;
+    m_used = 0;
+    m_free = nullptr;
+    m_merged = nullptr;
+    m_streaks = 1;
+    m_forward = nullptr;
+}
+
+TigerPool::~TigerPool(){
+    release();
+}
+
+// reuses a freed tiger if there is one, otherwise carves the next one out of the current slab. a full slab moves on to
+// the next kept slab, or a new one is allocated at the end
+Tiger *TigerPool::allocate(const Tiger& tiger){
+    void *memory;
+    if (m_free != nullptr){
+        memory = m_free;
+        m_free = m_free->m_left;
+    }else{
+        if (m_current == nullptr || m_used == SLABSIZE){
+            Slab *next = m_current == nullptr ? m_first : m_current->m_next;
+            if (next == nullptr){
+                next = new Slab;
+                next->m_next = nullptr;
+                if (m_current == nullptr){
+                    m_first = next;
+                }else{
+                    m_current->m_next = next;
+                }
+            }
+            m_current = next;
+            m_used = 0;
+        }
+        memory = m_current->m_tigers + m_used * sizeof(Tiger);
+        m_used++;
+    }
+    return new (memory) Tiger(tiger.getID(), tiger.getAge(), tiger.getGender(), tiger.getState());
+}
+
+// tigers hold nothing that needs destroying, so the memory goes straight on the free list
+void TigerPool::deallocate(Tiger *aTiger){
+    aTiger->m_left = m_free;
+    m_free = aTiger;
+}
+
+void TigerPool::deallocate(Tiger *first, Tiger *last){
+    if (first != nullptr){
+        last->m_left = m_free;
+        m_free = first;
+    }
+}
+
+void TigerPool::release(){
+    freeSlabs(m_first);
+    freeSlabs(m_merged);
+    m_first = nullptr;
+    m_merged = nullptr;
+    m_current = nullptr;
+    m_used = 0;
+    m_free = nullptr;
+}
+
+// forgets every tiger handed out and starts carving from the first slab again. merged slabs are free now too, so they
+// join the end of the chain
+void TigerPool::reset(){
+    if (m_merged != nullptr){
+        Slab **last = &m_first;
+        while (*last != nullptr){
+            last = &(*last)->m_next;
+        }
+        *last = m_merged;
+        m_merged = nullptr;
+    }
+    m_current = nullptr;
+    m_used = 0;
+    m_free = nullptr;
+}
+
+// takes over every slab and free tiger of other, whose tigers may be in use by other's streaks. those slabs are only
+// reused through the free list. other forwards to this pool from now on and its streaks count here
+void TigerPool::merge(TigerPool &other, const shared_ptr<TigerPool> &self){
+    Slab *slabs[2] = {other.m_first, other.m_merged};
+    for (Slab *slab : slabs){
+        while (slab != nullptr){
+            Slab *next = slab->m_next;
+            slab->m_next = m_merged;
+            m_merged = slab;
+            slab = next;
+        }
+    }
+    if (other.m_free != nullptr){
+        Tiger *last = other.m_free;
+        while (last->m_left != nullptr){
+            last = last->m_left;
+        }
+        last->m_left = m_free;
+        m_free = other.m_free;
+    }
+    m_streaks += other.m_streaks;
+    other.m_first = nullptr;
+    other.m_merged = nullptr;
+    other.m_current = nullptr;
+    other.m_used = 0;
+    other.m_free = nullptr;
+    other.m_streaks = 0;
+    other.m_forward = self;
+}
+
+void TigerPool::freeSlabs(Slab *slab){
+    while (slab != nullptr){
+        Slab *next = slab->m_next;
+        delete slab;
+        slab = next;
+    }
+}
 
 // constructor, sets m_root as nullptr
 Streak::Streak(){
     m_root = nullptr;
+    m_pool = make_shared<TigerPool>();
+    m_journal = nullptr;
 }
 
-// destructor, calls clear()
+// destructor, closes the journal, frees the tree and leaves the pool
 Streak::~Streak(){
-    clear();
-}
-
-// insert, checks if id is within MINID and MAXID, as well as if it is already in the tree, before inserting it
-void Streak::insert(const Tiger& tiger){
-    bool duplicate;
-    if (tiger.getID() >= MINID && tiger.getID() <= MAXID){
-        duplicate = findTiger(tiger.getID());
-        if (!duplicate){
-            insert(tiger, m_root);
-            // updates height of m_root after inserting
-            updateHeight(m_root);
-        }
+    if (m_journal != nullptr){
+        m_journal->close();
     }
+    clearTree();
+    pool().m_streaks--;
 }
 
-// deletes tree and sets m_root to nullptr
-void Streak::clear(){
-    clear(m_root);
-    m_root = nullptr;
+Streak::Streak(const Streak& other) : Streak(){
+    *this = other;
 }
 
-// removes a node if it exists in the tree
-void Streak::remove(int id){
-    if (findTiger(id)){
-        remove(id, m_root);
-    }
-}
-
-
-// updates height of a node
-void Streak::updateHeight(Tiger* aTiger){
-    // checks if aTiger is null so it doesn't segfault by accessing null members
-    if(aTiger != nullptr){
-        // if the tiger is a leaf node the height is 0
-        if (aTiger->getLeft() == nullptr && aTiger->getRight() == nullptr){
-            aTiger->setHeight(0);
-        // if the tiger has one child the height is that child+1
-        }else if (aTiger->getLeft() == nullptr && aTiger->getRight() != nullptr){
-            aTiger->setHeight(aTiger->getRight()->getHeight()+1);
-        }else if (aTiger->getLeft() != nullptr && aTiger->getRight() == nullptr){
-            aTiger->setHeight(aTiger->getLeft()->getHeight()+1);
-        // if the tiger has both children, compares greatest height and adds 1
-        }else if (aTiger->getLeft() != nullptr && aTiger->getRight() != nullptr){
-            if (aTiger->getLeft()->getHeight() > aTiger->getRight()->getHeight()){
-                aTiger->setHeight(aTiger->getLeft()->getHeight() + 1);
-            }else{
-                aTiger->setHeight(aTiger->getRight()->getHeight()+1);
-            }
+// the in order traversal gives a sorted batch, so the copy is built in linear time like a bulk build
+Streak& Streak::operator=(const Streak& other){
+    if (this != &other){
+        vector<uint32_t> batch;
+        batch.reserve(other.size());
+        other.forEachInRange(MINID, MAXID, [&batch](const Tiger &tiger){batch.push_back(pack(tiger));});
+        build(batch);
+    }
+    return *this;
+}
+
+// insert, checks if id is within MINID and MAXID before inserting it. walks down once, recording the link to every
+// node on the way, so duplicates are detected in the same descent and the root is fixed in one place by retrace
+RESULT Streak::insert(const Tiger& tiger){
+    if (tiger.getID() < MINID || tiger.getID() > MAXID){
+        return OUTOFRANGE;
+    }
+    Tiger **path[MAXDEPTH];
+    int depth = 0;
+    Tiger **link = &m_root;
+    while (*link != nullptr){
+        // if the id is already in the tree, nothing is inserted
+        if (tiger.getID() == (*link)->getID()){
+            return DUPLICATE;
+        }
+        path[depth++] = link;
+        if (tiger.getID() < (*link)->getID()){
+            link = &(*link)->m_left;
+        }else{
+            link = &(*link)->m_right;
         }
     }
+    // the new tiger starts as a leaf, whatever links the caller's copy had
+    *link = pool().allocate(tiger);
+    Balance::retrace(path, depth);
+    if (m_journal != nullptr){
+        m_journal->record(INSERTRECORD, tiger.getID(), packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState()));
+    }
+    return INSERTED;
 }
 
+void Streak::clear(bool keepSlab){
+    clearTree(keepSlab);
+    compactJournal();
+}
 
-// checks the imbalance of a current node
-int Streak::checkImbalance(Tiger* aTiger){
-    // if aTiger's children are leaf nodes the imbalance factor is 0
-    if (aTiger->getLeft() == nullptr && aTiger->getRight() == nullptr){
-        return 0;
+// deletes tree and sets m_root to nullptr. every tiger lives in the pool, so if no other streak draws from it there is
+// no traversal, the slabs are freed or kept for reuse at once. a shared pool gets the tigers back one by one
+void Streak::clearTree(bool keepSlab){
+    TigerPool &tigers = pool();
+    if (tigers.m_streaks > 1){
+        clear(m_root);
+    }else if (keepSlab){
+        tigers.reset();
+    }else{
+        tigers.release();
+    }
+    m_root = nullptr;
+}
+
+bool Streak::remove(int id){
+    int visits;
+    return remove(id, visits);
+}
+
+// removes a node if it exists in the tree, in one pass with no separate findTiger probe. a node with two children is
+// replaced by its in-order successor, which is spliced out of the right subtree during the same descent. visits is
+// set to the # of nodes the descent and the retrace looked at
+bool Streak::remove(int id, int &visits){
+    Tiger **path[MAXDEPTH];
+    int depth = 0;
+    Tiger **link = &m_root;
+    while (*link != nullptr && (*link)->getID() != id){
+        path[depth++] = link;
+        if (id < (*link)->getID()){
+            link = &(*link)->m_left;
+        }else{
+            link = &(*link)->m_right;
+        }
+    }
+    Tiger *toDelete = *link;
+    if (toDelete == nullptr){
+        visits = depth;
+        return false;
     }
-    // if the tiger has one child, subtracts heights with factor of -1
-    if (aTiger->getLeft() == nullptr && aTiger->getRight() != nullptr){
-        return -1-aTiger->getRight()->getHeight();
+    // zero or one child, the child (or nullptr) takes the node's place
+    if (toDelete->m_left == nullptr){
+        *link = toDelete->m_right;
+    }else if (toDelete->m_right == nullptr){
+        *link = toDelete->m_left;
+    }else{
+        // two children, keep descending to the leftmost node of the right subtree
+        int top = depth;
+        path[depth++] = link;
+        Tiger **successorLink = &toDelete->m_right;
+        while ((*successorLink)->m_left != nullptr){
+            path[depth++] = successorLink;
+            successorLink = &(*successorLink)->m_left;
+        }
+        Tiger *successor = *successorLink;
+        *successorLink = successor->m_right;
+        successor->m_left = toDelete->m_left;
+        successor->m_right = toDelete->m_right;
+        successor->m_height = toDelete->m_height;
+        *link = successor;
+        // the path entry below the removed node pointed into it, it has to point into the successor now
+        if (depth > top + 1){
+            path[top + 1] = &successor->m_right;
+        }
     }
-    if (aTiger->getLeft() != nullptr && aTiger->getRight() == nullptr){
-        return aTiger->getLeft()->getHeight()-(-1);
+    pool().deallocate(toDelete);
+    // the path holds every node the descent passed, the last of them being the successor's parent, and the removed
+    // node or the successor itself is one more
+    visits = depth + 1 + Balance::retrace(path, depth);
+    if (m_journal != nullptr){
+        m_journal->record(REMOVERECORD, id);
     }
-    // subtracts left child height from right child height
-    return aTiger->getLeft()->getHeight()-aTiger->getRight()->getHeight();
+    return true;
 }
 
 
-// rebalances an imbalanced node
-Tiger *Streak::rebalance(Tiger* aTiger){
-    // checks if aTiger is not null so there isn't seg fault when trying to access null members
+// recomputes the subtree size and the per subtree AGE/GENDER/STATE counts of a node from its children, which have to be up to date
+void TigerCounts::update(Tiger* aTiger){
     if (aTiger != nullptr){
-        // checks imbalance of current node
-        int imbalance = checkImbalance(aTiger);
-        // if there isn't an imbalance nothing happens
-        if (imbalance < 2 && imbalance >= -1){
-            return aTiger;
-        // if the imbalance is on the left side
-        }else if (imbalance > 1){
-            // takes imbalance factor of left child to see which of it's children have more children
-            int child = checkImbalance(aTiger->getLeft());
-            // if the second imbalance factor is >= 0 then it is a single right rotation. returns the root of that
-            // rotation
-            if (child >= 0){
-                Tiger *balanced = singleRight(aTiger);
-                return balanced;
-            }
-            // if the second imbalance factor is <= 0 then it is a double left right rotation. returns the root of that
-            // rotation
-            if (child < 0){
-                Tiger *balanced = leftRight(aTiger);
-                return balanced;
-            }
-        // if the imbalance is on the right side
-        }else if (imbalance < -1){
-            // takes balance factor of its right child to see which side has the most children
-            int child = checkImbalance(aTiger->getRight());
-            // if the second imbalance factor is <= 0, then it is a single left rotation. returns the root of that
-            // rotation
-            if (child <= 0){
-                Tiger *balanced = singleLeft(aTiger);
-                return balanced;
-            }
-            // if the second imbalance factor is >= 0, then it is a double right left rotation. returns the root of that
-            // rotation
-            if (child > 0){
-                Tiger *balanced = rightLeft(aTiger);
-                return balanced;
+        aTiger->resetCounts();
+        Tiger *children[2] = {aTiger->getLeft(), aTiger->getRight()};
+        for (Tiger *child : children){
+            if (child != nullptr){
+                for (int i = 0; i < 3; i++){
+                    aTiger->m_ages[i] += child->m_ages[i];
+                    aTiger->m_genders[i] += child->m_genders[i];
+                }
+                aTiger->m_states[ALIVE] += child->m_states[ALIVE];
+                aTiger->m_states[DEAD] += child->m_states[DEAD];
+                aTiger->m_size += child->m_size;
             }
         }
     }
-    // returns null if none of these conditions apply
-    return nullptr;
 }
 
 void Streak::dumpTree() const {dump(m_root);}
@@ -142,17 +304,49 @@ void Streak::listTigers() const {
     listTigers(m_root);
 }
 
-// sets state of specific tiger; checks if it exists
+// sets state of specific tiger; checks if it exists. the counts of the tiger and all of its ancestors are fixed on the
+// way back up the same descent
 bool Streak::setState(int id, STATE state){
-    if (findTiger(id)) {
-        getTiger(id)->setState(state);
+    Tiger *path[MAXDEPTH];
+    int depth = 0;
+    Tiger *aTiger = m_root;
+    while (aTiger != nullptr && aTiger->getID() != id){
+        path[depth++] = aTiger;
+        if (id < aTiger->getID()){
+            aTiger = aTiger->getLeft();
+        }else{
+            aTiger = aTiger->getRight();
+        }
+    }
+    if (aTiger == nullptr){
+        return false;
+    }
+    // the tiger is found either way, but the counts and the journal only change with the state
+    if (aTiger->getState() == state){
         return true;
     }
-    return false;
+    aTiger->setState(state);
+    TigerCounts::update(aTiger);
+    while (depth > 0){
+        TigerCounts::update(path[--depth]);
+    }
+    if (m_journal != nullptr){
+        m_journal->record(STATERECORD, id, packAttrs(CUB, MALE, state));
+    }
+    return true;
 }
 
-void Streak::removeDead(){
-    findDead(m_root);
+// removes all dead tigers in O(n): one in order pass keeps the alive tigers in a list and deletes the dead ones, then
+// the alive nodes themselves are rebuilt into a perfectly balanced tree
+int Streak::removeDead(){
+    int kept = 0;
+    int removed = 0;
+    Tiger *list = filterDead(m_root, nullptr, kept, removed);
+    m_root = buildBalanced(list, kept);
+    if (m_journal != nullptr && removed > 0){
+        m_journal->record(REMOVEDEADRECORD);
+    }
+    return removed;
 }
 
 // returns true if tiger is in tree. returns false if it isn't
@@ -164,272 +358,355 @@ bool Streak::findTiger(int id) const {
     return false;
 }
 
+// the root counts every tiger in the streak, so these are O(1)
 int Streak::countTigerCubs() const{
-    int total = 0;
-    countTigerCubs(total, m_root);
-    return total;
+    return countBy(CUB);
+}
+
+int Streak::countBy(AGE age) const{
+    if (m_root == nullptr){
+        return 0;
+    }
+    return m_root->m_ages[age];
+}
+
+int Streak::countBy(GENDER gender) const{
+    if (m_root == nullptr){
+        return 0;
+    }
+    return m_root->m_genders[gender];
 }
 
-// recursively deletes a tree by post order traversal
+int Streak::countBy(STATE state) const{
+    if (m_root == nullptr){
+        return 0;
+    }
+    return m_root->m_states[state];
+}
+
+int Streak::size() const{
+    if (m_root == nullptr){
+        return 0;
+    }
+    return m_root->m_size;
+}
+
+// counts the tigers with a smaller id in one descent, every time it goes right the left subtree and the node itself
+// are all smaller
+int Streak::rank(int id) const{
+    int smaller = 0;
+    Tiger *aTiger = m_root;
+    while (aTiger != nullptr){
+        if (id <= aTiger->getID()){
+            aTiger = aTiger->getLeft();
+        }else{
+            if (aTiger->getLeft() != nullptr){
+                smaller += aTiger->getLeft()->m_size;
+            }
+            smaller++;
+            aTiger = aTiger->getRight();
+        }
+    }
+    return smaller;
+}
+
+// two rank descents, everything below hi+1 minus everything below lo
+int Streak::countInRange(int lo, int hi) const{
+    if (lo > hi){
+        return 0;
+    }
+    // hi + 1 would overflow for hi == INT_MAX, and no id is above MAXID anyway
+    return (hi >= MAXID ? size() : rank(hi + 1)) - rank(lo);
+}
+
+// finds the k-th smallest id in one descent, using the left subtree sizes to pick a side
+int Streak::select(int k) const{
+    if (k < 0 || k >= size()){
+        return DEFAULT_ID;
+    }
+    Tiger *aTiger = m_root;
+    while (true){
+        int left = 0;
+        if (aTiger->getLeft() != nullptr){
+            left = aTiger->getLeft()->m_size;
+        }
+        if (k == left){
+            return aTiger->getID();
+        }else if (k < left){
+            aTiger = aTiger->getLeft();
+        }else{
+            k -= left + 1;
+            aTiger = aTiger->getRight();
+        }
+    }
+}
+
+// the pool every tiger of this streak lives in. a merged pool forwards to the pool it was merged into, and the streak
+// follows it so later calls go straight there
+TigerPool &Streak::pool(){
+    while (m_pool->m_forward != nullptr){
+        m_pool = m_pool->m_forward;
+    }
+    return *m_pool;
+}
+
+// recursively gives a tree back to the pool by post order traversal
 void Streak::clear(Tiger *aTiger) {
     if (aTiger != nullptr){
         clear(aTiger->getLeft());
         clear(aTiger->getRight());
-        delete aTiger;
+        pool().deallocate(aTiger);
     }
 }
 
-// checks for duplicates in a tree recursively
-bool Streak::duplicates(int id, Tiger *aTiger) const{
-    // if aTiger is null that means we reached the bottom of the tree so that means the tiger did not exist
-    if (aTiger == nullptr){
+StreakView Streak::freezeView() const{
+    vector<uint32_t> sorted;
+    sorted.reserve(size());
+    forEachInRange(MINID, MAXID, [&sorted](const Tiger &tiger){sorted.push_back(pack(tiger));});
+    return StreakView(sorted);
+}
+
+// syncs a file written next to path and renames it over path, so after a crash path holds the old contents or the
+// new ones, never a part. the temporary file is removed if written is false or anything fails
+static bool commitFile(const string &temporary, const string &path, bool written){
+    if (written){
+        int file = open(temporary.c_str(), O_RDONLY);
+        written = file >= 0 && fsync(file) == 0;
+        if (file >= 0){
+            close(file);
+        }
+    }
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0){
+        std::remove(temporary.c_str());
         return false;
-    // returns true if tiger is found
-    }else if (aTiger->getID() == id){
-        return true;
-    // if the id is larger than the current tiger's id, recurses to the right
-    }else if (aTiger->getID() < id){
-        return duplicates(id, aTiger->getRight());
-    }else{
-    // if the id is smaller than the current tiger's id, recurses to the left
-        return duplicates(id, aTiger->getLeft());
     }
+    return true;
 }
 
-// inserts nodes into tree then updates height and rebalances the tree (recursively)
-void Streak::insert(const Tiger &tiger, Tiger *&aTiger) {
-    // base case, if at the bottom  of the tree, add a new tiger
-    if (aTiger == nullptr){
-        Tiger *newTiger = new Tiger(tiger);
-        aTiger = newTiger;
-    // if the id is smaller than aTiger's id, recurse to the left
-    }else if (tiger.getID() < aTiger->getID()) {
-        insert(tiger, aTiger->m_left);
-        // recursive return call, updates height and rebalances
-        updateHeight(aTiger->m_left);
-
-        // if aTiger is the root, case is different; updates height and rebalances
-        if (aTiger != m_root){
-            aTiger->setLeft(rebalance(aTiger->getLeft()));
-        }else{
-            aTiger->setLeft(rebalance(aTiger->getLeft()));
-            m_root = rebalance(aTiger);
+// the ids go first so the varints of a dense roster stay one byte each, the attribute bytes follow in one run
+bool Streak::save(const string &path) const{
+    vector<uint8_t> image;
+    image.reserve(SNAPSHOTHEADER + 4 * size() + 4);
+    // the version and the zero after it are one 32 bit field
+    const uint32_t header[3] = {SNAPSHOTMAGIC, SNAPSHOTVERSION, (uint32_t)size()};
+    for (uint32_t field : header){
+        for (int byte = 0; byte < 4; byte++){
+            image.push_back((field >> (8 * byte)) & 0xFF);
         }
-    }else{
-        // if the id is larger than aTiger's id, recurse to right
-        insert(tiger, aTiger->m_right);
-        // recursive return call, updates height and rebalances
-        updateHeight(aTiger->m_right);
-
-        // if aTiger is the root, case is different; updates height and rebalances
-        if (aTiger != m_root){
-            aTiger->setRight(rebalance(aTiger->getRight()));
-        }else{
-            aTiger->setRight(rebalance(aTiger->getRight()));
-            m_root = rebalance(aTiger);
+    }
+    int previous = MINID - 1;
+    forEachInRange(MINID, MAXID, [&image, &previous](const Tiger &tiger){
+        uint32_t delta = tiger.getID() - previous;
+        previous = tiger.getID();
+        while (delta >= 0x80){
+            image.push_back((delta & 0x7F) | 0x80);
+            delta >>= 7;
         }
+        image.push_back(delta);
+    });
+    forEachInRange(MINID, MAXID, [&image](const Tiger &tiger){
+        image.push_back(packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState()));
+    });
+    uint32_t crc = crc32(image.data(), image.size());
+    for (int byte = 0; byte < 4; byte++){
+        image.push_back((crc >> (8 * byte)) & 0xFF);
     }
+    const string temporary = path + ".tmp";
+    ofstream out(temporary, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(image.data()), image.size());
+    out.close();
+    return commitFile(temporary, path, !out.fail());
 }
 
-// single left rotation
-Tiger *Streak::singleLeft(Tiger *aTiger) {
-    Tiger *z = aTiger;
-    // gets z's right
-    Tiger *y = aTiger->getRight();
-    // sets z's right to y's left
-    z->setRight(y->getLeft());
-    // sets y's left to z
-    y->setLeft(z);
-
-    // updates heights of both y and z and returns y as root of subtree
-    updateHeight(z);
-    updateHeight(y);
-    return y;
-}
-
-// single right rotation
-Tiger *Streak::singleRight(Tiger *aTiger) {
-    Tiger *z = aTiger;
-    // gets z's left
-    Tiger *y = z->getLeft();
-    // sets z's left to y's right
-    z->setLeft(y->getRight());
-    // sets y's right to z
-    y->setRight(z);
-
-    // updates both heights and returns y as root of subtree
-    updateHeight(z);
-    updateHeight(y);
-    return y;
-}
-
-
-// double left right rotation
-Tiger *Streak::leftRight(Tiger *aTiger) {
-    Tiger *z = aTiger;
-    // gets left of z
-    Tiger *y = z->getLeft();
-    // gets right of y
-    Tiger *x = y->getRight();
-    // sets z's left to x's right
-    z->setLeft(x->getRight());
-    // sets x's right to z
-    x->setRight(z);
-    // sets y's right to x's left
-    y->setRight(x->getLeft());
-    // sets x's left to y
-    x->setLeft(y);
-
-    // updates hright of all three nodes and returns x as root of subtree
-    updateHeight(z);
-    updateHeight(y);
-    updateHeight(x);
-    return x;
-}
-
-
-// double right left rotation
-Tiger *Streak::rightLeft(Tiger *aTiger) {
-    Tiger *z = aTiger;
-    // gets z's right
-    Tiger *y = z->getRight();
-    // gets y's left
-    Tiger *x = y->getLeft();
-    // sets z's right to x's left
-    z->setRight(x->getLeft());
-    // sets x's left to z
-    x->setLeft(z);
-    // sets y's left ro x's right
-    y->setLeft(x->getRight());
-    // sets x's right to y
-    x->setRight(y);
-
-    // updates height of all three nodes and returns x as root of subtree
-    updateHeight(z);
-    updateHeight(y);
-    updateHeight(x);
-    return x;
-}
-
-// recursively removes a node while updating height and rebalancing tree
-void Streak::remove(int id, Tiger *&aTiger) {
-    // if id is greater than aTiger's id, recurse to aTiger's right
-    if (aTiger->getID() < id){
-        remove(id, aTiger->m_right);
-        // recursive return, update height and rebalance
-        updateHeight(aTiger->m_right);
-
-        // if aTiger is the root, case is different; updates height and rebalances
-        if (aTiger != m_root){
-            aTiger->setRight(rebalance(aTiger->m_right));
-        }else{
-            aTiger->setRight(rebalance(aTiger->m_right));
-            m_root = rebalance(aTiger);
-        }
-    // if id is less than aTiger's id, recurse to aTiger's left
-    }else if (aTiger->getID() > id){
-        remove(id, aTiger->m_left);
-        // recursive return, update height and rebalance
-        updateHeight(aTiger->m_left);
-
-        // if aTiger is the root, case is different; updates height and rebalances
-        if (aTiger != m_root){
-            aTiger->setLeft(rebalance(aTiger->getLeft()));
-        }else{
-            aTiger->setLeft(rebalance(aTiger->getLeft()));
-            m_root = rebalance(aTiger);
+// reads the whole file, checks it, and decodes it into a packed batch that is already sorted and free of duplicates.
+// the old tree is only given up once every check has passed
+bool Streak::load(const string &path){
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in){
+        return false;
+    }
+    const streamoff length = in.tellg();
+    if (length < SNAPSHOTHEADER + 4){
+        return false;
+    }
+    vector<uint8_t> image(length);
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(image.data()), length)){
+        return false;
+    }
+    auto field = [&image](int at, int width){
+        uint32_t value = 0;
+        for (int byte = width - 1; byte >= 0; byte--){
+            value = value << 8 | image[at + byte];
         }
-    // if the id matches aTiger's id
-    }else if (aTiger->getID() == id) {
-        // if aTiger is the root and the root is the only node in the tree, delete the root
-        if (aTiger == m_root && !aTiger->getLeft() && !aTiger->getRight()){
-            delete aTiger;
-            m_root = nullptr;
-        // if the tiger is a leaf node
-        }else if (aTiger->getLeft() == nullptr && aTiger->getRight() == nullptr) {
-            // keep temporary variable as tiger and retrieve tiger pointing to it
-            // delete the tiger and update height of the tiger which was pointing to it
-            Tiger *toDelete = aTiger;
-            Tiger *temp = removeHelper(aTiger->getID(), m_root);
-            delete toDelete;
-            updateHeight(temp);
-        // if the tiger has one child
-        }else if (aTiger->getLeft() != nullptr && aTiger->getRight() == nullptr){
-            // if the tiger has a left child, copy variables of its child to itself
-            Tiger *temp = aTiger->getLeft();
-            assignTiger(1, aTiger, temp);
-
-            // delete the child and update height of the tiger, then rebalance
-            temp->setLeft(nullptr);
-            temp->setRight(nullptr);
-            delete temp;
-            updateHeight(aTiger);
-            aTiger->setLeft(rebalance(aTiger->getLeft()));
-        }else if (aTiger->getRight() != nullptr && aTiger->getLeft() == nullptr){
-            // if the tiger has a right child, copy variables of its child to itself
-            Tiger *temp = aTiger->getRight();
-            assignTiger(1, aTiger, temp);
-
-            // deletes the child and update the height of the tiger, then rebalance
-            temp->setLeft(nullptr);
-            temp->setRight(nullptr);
-            delete temp;
-            updateHeight(aTiger);
-            aTiger->setRight(rebalance(aTiger->getRight()));
-        // if the tiger has two children
-        }else if (aTiger->getLeft() != nullptr && aTiger->getRight() != nullptr){
-            // if the tiger is not the root
-            if (aTiger != m_root){
-                if (aTiger->getRight()->getLeft() == nullptr){
-                    Tiger *temp = aTiger->getRight();
-                    assignTiger(2, aTiger, temp);
-                    aTiger->setRight(nullptr);
-                    delete temp;
-                }else{
-                    // normal case, update height and rebalance
-                    Tiger *temp = minTigerParent(aTiger->getRight());
-                    Tiger *toDelete = temp->getLeft();
-                    assignTiger(2, aTiger, toDelete);
-                    twoChildrenRemove(temp, toDelete);
-                    updateHeight(temp);
-                    removeRebalance(temp->getID(), m_root);
-                }
-            // if tiger is m_root
-            }else if (aTiger == m_root){
-                if (aTiger->getRight()->getLeft() == nullptr){
-                    Tiger *temp = aTiger->getRight();
-                    assignTiger(2, aTiger, temp);
-                    if (temp->getRight()){
-                        aTiger->setRight(temp->getRight());
-                    }
-                    delete temp;
-                }else{
-                    // normal case, update height and rebalance
-                    Tiger *temp = minTigerParent(aTiger->getRight());
-                    Tiger *toDelete = temp->getLeft();
-                    assignTiger(2, aTiger, toDelete);
-                    twoChildrenRemove(temp, toDelete);
-                    updateHeight(temp);
-                    removeRebalance(temp->getID(), m_root);
-                }
-                m_root = rebalance(aTiger);
+        return value;
+    };
+    const size_t end = length - 4;
+    const uint32_t count = field(8, 4);
+    if (field(0, 4) != SNAPSHOTMAGIC || field(4, 2) != SNAPSHOTVERSION || field(6, 2) != 0
+        || count > (uint32_t)(MAXID - MINID + 1) || count > end - SNAPSHOTHEADER
+        || crc32(image.data(), end) != field(end, 4)){
+        return false;
+    }
+    vector<uint32_t> batch(count);
+    size_t at = SNAPSHOTHEADER;
+    int id = MINID - 1;
+    for (uint32_t i = 0; i < count; i++){
+        uint32_t delta = 0;
+        for (int shift = 0; ; shift += 7){
+            // a delta is at most MAXID - MINID + 1, which takes three bytes
+            if (at >= end || shift > 14){
+                return false;
             }
+            uint8_t byte = image[at++];
+            delta |= (uint32_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0){
+                break;
+            }
+        }
+        if (delta == 0 || delta > (uint32_t)(MAXID - id)){
+            return false;
+        }
+        id += delta;
+        batch[i] = (uint32_t)(id - MINID) << 8;
+    }
+    if (end - at != count){
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++){
+        if (!validAttrs(image[at + i])){
+            return false;
+        }
+        batch[i] |= image[at + i];
+    }
+    clearTree(true);
+    int built = 0;
+    m_root = buildBatch(batch, built, true);
+    compactJournal();
+    return true;
+}
+
+// the nodes go into the image in id order, and the tree over them is the balanced one buildBalanced would make: the
+// middle of every range is its root. the counts come from the root, which holds them for the whole streak
+bool Streak::saveImage(const string &path) const{
+    const int count = size();
+    vector<CompactTiger> nodes(count + 1, CompactTiger());
+    int next = 1;
+    forEachInRange(MINID, MAXID, [&nodes, &next](const Tiger &tiger){
+        nodes[next].m_key = tiger.getID() - MINID;
+        nodes[next].m_attrs = packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState());
+        next++;
+    });
+    ImageHeader header = {};
+    header.m_magic = IMAGEMAGIC;
+    header.m_version = IMAGEVERSION;
+    header.m_nodeSize = sizeof(CompactTiger);
+    header.m_count = count;
+    header.m_root = linkImage(nodes, 1, count);
+    header.m_crc = crc32(reinterpret_cast<const uint8_t*>(nodes.data()), nodes.size() * sizeof(CompactTiger));
+    for (int i = 0; i < 3; i++){
+        header.m_ages[i] = countBy(static_cast<AGE>(i));
+        header.m_genders[i] = countBy(static_cast<GENDER>(i));
+    }
+    header.m_states[ALIVE] = countBy(ALIVE);
+    header.m_states[DEAD] = countBy(DEAD);
+    const string temporary = path + ".tmp";
+    ofstream out(temporary, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(CompactTiger));
+    out.close();
+    return commitFile(temporary, path, !out.fail());
+}
+
+void Streak::attach(StreakJournal *journal){
+    m_journal = journal;
+}
+
+// a journal has no records for the updates that replace the whole tree, so after one the whole streak goes into a new
+// snapshot instead. returns false if that failed: the journal is closed and detached then, and its sync reports it
+bool Streak::compactJournal(){
+    return m_journal == nullptr || m_journal->compact();
+}
+
+// journals an insert for every tiger of aTiger's subtree that is not in the streak, before a bulk update adds them.
+// O(k log n) for k tigers, so the journal grows with the update instead of being folded into a new snapshot
+void Streak::recordInserts(Tiger *aTiger){
+    if (m_journal == nullptr){
+        return;
+    }
+    auto record = [this](const Tiger &tiger){
+        if (!duplicates(tiger.getID(), m_root)){
+            m_journal->record(INSERTRECORD, tiger.getID(), packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState()));
+        }
+    };
+    forEachInRange(MINID, MAXID, record, aTiger);
+}
+
+// journals a remove for every tiger of aTiger's subtree that is in other, or that is not if inOther is false, for the
+// bulk updates that take part of the tigers away
+void Streak::recordRemoves(Tiger *aTiger, Tiger *other, bool inOther){
+    if (m_journal == nullptr){
+        return;
+    }
+    auto record = [this, other, inOther](const Tiger &tiger){
+        if (duplicates(tiger.getID(), other) == inOther){
+            m_journal->record(REMOVERECORD, tiger.getID());
         }
+    };
+    forEachInRange(MINID, MAXID, record, aTiger);
+}
+
+// links the nodes lo..hi of an image into a balanced tree and returns its root, NIL for an empty range
+uint32_t Streak::linkImage(vector<CompactTiger> &nodes, int lo, int hi){
+    if (lo > hi){
+        return NIL;
     }
+    int mid = lo + (hi - lo) / 2;
+    CompactTiger &node = nodes[mid];
+    node.m_left = linkImage(nodes, lo, mid - 1);
+    node.m_right = linkImage(nodes, mid + 1, hi);
+    node.m_height = max(nodes[node.m_left].m_height, nodes[node.m_right].m_height) + 1;
+    return mid;
 }
 
+// table driven CRC-32, the table is filled on the first call
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc){
+    static const vector<uint32_t> table = []{
+        vector<uint32_t> entries(256);
+        for (uint32_t i = 0; i < 256; i++){
+            uint32_t entry = i;
+            for (int bit = 0; bit < 8; bit++){
+                entry = (entry & 1) ? 0xEDB88320 ^ (entry >> 1) : entry >> 1;
+            }
+            entries[i] = entry;
+        }
+        return entries;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++){
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
 
-// copies member variables from one tiger to the other
-void Streak::assignTiger(int num, Tiger *aTiger, Tiger *secondTiger) {
-    aTiger->setID(secondTiger->getID());
-    aTiger->setState(secondTiger->getState());
-    aTiger->setAge(secondTiger->getAge());
-    if (num == 1){
-        aTiger->setLeft(secondTiger->getLeft());
-        aTiger->setRight(secondTiger->getRight());
+// checks for duplicates in a tree recursively
+bool Streak::duplicates(int id, Tiger *aTiger) const{
+    // if aTiger is null that means we reached the bottom of the tree so that means the tiger did not exist
+    if (aTiger == nullptr){
+        return false;
+    // returns true if tiger is found
+    }else if (aTiger->getID() == id){
+        return true;
+    // if the id is larger than the current tiger's id, recurses to the right
+    }else if (aTiger->getID() < id){
+        return duplicates(id, aTiger->getRight());
+    }else{
+    // if the id is smaller than the current tiger's id, recurses to the left
+        return duplicates(id, aTiger->getLeft());
     }
 }
 
+
 Tiger *Streak::getTiger(int id) {
     return getTigerHelper(id, m_root);
 }
@@ -449,25 +726,6 @@ Tiger *Streak::getTigerHelper(int id, Tiger *aTiger) {
     }
 }
 
-Tiger *Streak::minTigerParent(Tiger *aTiger) {
-    if (aTiger->getLeft()->getLeft() == nullptr){
-        return aTiger;
-    }else{
-        return minTigerParent(aTiger->getLeft());
-    }
-}
-
-void Streak::twoChildrenRemove(Tiger *parent, Tiger *toDelete) {
-    if (toDelete->getRight() == nullptr){
-        parent->setLeft(nullptr);
-        delete toDelete;
-    }else if(toDelete->getRight() != nullptr){
-        Tiger *temp = toDelete->getRight();
-        parent->setLeft(temp);
-        delete toDelete;
-    }
-}
-
 // lists tigers and their elements, in order traversal
 void Streak::listTigers(Tiger *aTiger) const{
     // checks if not nullptr to avoid segfault from accessing null members
@@ -480,67 +738,538 @@ void Streak::listTigers(Tiger *aTiger) const{
 }
 
 
-// finds all dead tigers and deletes them, in order traversal
-void Streak::findDead(Tiger *aTiger) {
+// threads the alive tigers into a list through m_right and deletes the dead ones. the traversal is reverse in order
+// and pushes to the front, so the list comes out smallest id first. returns the new head of the list
+Tiger *Streak::filterDead(Tiger *aTiger, Tiger *list, int &kept, int &removed) {
     // checks if not nullptr to avoid segfault from accessing null members
-    if (aTiger != nullptr){
-        findDead(aTiger->getLeft());
-        // if it finds the dead tiger, deletes it
-        if (aTiger->getState() == 1){
-            deadTiger(aTiger->getID());
-            return;
+    if (aTiger == nullptr){
+        return list;
+    }
+    Tiger *left = aTiger->getLeft();
+    list = filterDead(aTiger->getRight(), list, kept, removed);
+    if (aTiger->getState() == DEAD){
+        pool().deallocate(aTiger);
+        removed++;
+    }else{
+        aTiger->setLeft(nullptr);
+        aTiger->setRight(list);
+        list = aTiger;
+        kept++;
+    }
+    return filterDead(left, list, kept, removed);
+}
+
+// replaces the tree with a packed batch
+int Streak::build(vector<uint32_t> &batch){
+    clearTree(true);
+    int count = 0;
+    m_root = buildBatch(batch, count);
+    compactJournal();
+    return count;
+}
+
+// sorts a packed batch, keeps the first tiger of every id and links fresh nodes from the pool into a list that
+// buildBalanced turns into a tree, all in linear time. a batch that is already sorted skips the sort. returns the
+// root and sets count to the # of tigers in it
+Tiger *Streak::buildBatch(vector<uint32_t> &batch, int &count, bool sorted){
+    if (!sorted){
+        sortBatch(batch);
+    }
+    Tiger *list = nullptr;
+    Tiger **tail = &list;
+    count = 0;
+    for (unsigned int i = 0; i < batch.size(); i++){
+        uint32_t key = batch[i] >> 8;
+        // the sort is stable, so the first of equal ids is the one that came first in the batch
+        if (i > 0 && key == batch[i - 1] >> 8){
+            continue;
         }
-        findDead(aTiger->getRight());
+        uint8_t attrs = batch[i] & 0xFF;
+        *tail = pool().allocate(Tiger(key + MINID, unpackAge(attrs), unpackGender(attrs), unpackState(attrs)));
+        tail = &(*tail)->m_right;
+        count++;
     }
+    return buildBalanced(list, count);
 }
 
-// counts all tiger cubs in a tree, in order traversal
-void Streak::countTigerCubs(int &total, Tiger *aTiger) const {
-    // checks if not nullptr to avoid segfault from accessing null members
-    if (aTiger != nullptr){
-        countTigerCubs(total, aTiger->getLeft());
-        // if it finds a cub, increments the total
-        if (aTiger->getAge() == 0){
-            total++;
+// packs a tiger as (id - MINID) << 8 | attrs, so batches can be radix sorted on the 17 id bits
+uint32_t Streak::pack(const Tiger& tiger){
+    return (uint32_t)(tiger.getID() - MINID) << 8 | packAttrs(tiger.getAge(), tiger.getGender(), tiger.getState());
+}
+
+// stable LSD radix sort of packed tigers on their 17 id bits, one pass over bits 8-16 and one over bits 17-24
+void Streak::sortBatch(vector<uint32_t> &batch){
+    vector<uint32_t> buffer(batch.size());
+    const int shifts[2] = {8, 17};
+    const int radix[2] = {512, 256};
+    for (int pass = 0; pass < 2; pass++){
+        vector<int> offsets(radix[pass] + 1, 0);
+        for (uint32_t tiger : batch){
+            offsets[((tiger >> shifts[pass]) & (radix[pass] - 1)) + 1]++;
+        }
+        for (int digit = 0; digit < radix[pass]; digit++){
+            offsets[digit + 1] += offsets[digit];
         }
-        countTigerCubs(total, aTiger->getRight());
+        for (uint32_t tiger : batch){
+            buffer[offsets[(tiger >> shifts[pass]) & (radix[pass] - 1)]++] = tiger;
+        }
+        batch.swap(buffer);
     }
 }
 
-Tiger* Streak::removeHelper(int id, Tiger *aTiger) {
-    if (aTiger->getLeft() && aTiger->getLeft()->getID() == id){
-        aTiger->setLeft(nullptr);
+// builds the batch into its own balanced tree and unites it with the streak. tigers already in the streak win over
+// the batch, like insert reporting DUPLICATE
+int Streak::insertBatch(const vector<Tiger>& tigers){
+    vector<uint32_t> batch;
+    batch.reserve(tigers.size());
+    for (const Tiger &tiger : tigers){
+        if (tiger.getID() >= MINID && tiger.getID() <= MAXID){
+            batch.push_back(pack(tiger));
+        }
+    }
+    int count = 0;
+    int added = 0;
+    FreeList freed;
+    Tiger *batchTree = buildBatch(batch, count);
+    recordInserts(batchTree);
+    m_root = unite(m_root, batchTree, added, freed);
+    deallocate(freed);
+    return added;
+}
+
+// joins two trees and a detached pivot, with every id in left < pivot < every id in right, into one balanced tree.
+// walks down the spine of the taller tree until the heights are within one, hangs the pivot there and rebalances on
+// the way back up, like an insert. O(|height(left) - height(right)| + 1)
+Tiger *Streak::join(Tiger *left, Tiger *pivot, Tiger *right){
+    if (Balance::height(left) > Balance::height(right) + 1){
+        left->setRight(join(left->getRight(), pivot, right));
+        Balance::update(left);
+        return Balance::rebalance(left);
+    }
+    if (Balance::height(right) > Balance::height(left) + 1){
+        right->setLeft(join(left, pivot, right->getLeft()));
+        Balance::update(right);
+        return Balance::rebalance(right);
+    }
+    pivot->setLeft(left);
+    pivot->setRight(right);
+    Balance::update(pivot);
+    return pivot;
+}
+
+// splits a tree into the ids smaller than id (left) and larger than id (right). the tiger with id, if there is one, is
+// detached as a leaf into found. every node on the search path is joined back in as a pivot, O(log n)
+void Streak::split(Tiger *aTiger, int id, Tiger *&left, Tiger *&found, Tiger *&right){
+    if (aTiger == nullptr){
+        left = nullptr;
+        found = nullptr;
+        right = nullptr;
+        return;
+    }
+    Tiger *smaller = aTiger->getLeft();
+    Tiger *larger = aTiger->getRight();
+    if (id == aTiger->getID()){
+        left = smaller;
+        right = larger;
+        found = aTiger;
+        found->setLeft(nullptr);
+        found->setRight(nullptr);
+        found->setHeight(DEFAULT_HEIGHT);
+        found->resetCounts();
+    }else if (id < aTiger->getID()){
+        Tiger *rest;
+        split(smaller, id, left, found, rest);
+        right = join(rest, aTiger, larger);
+    }else{
+        Tiger *rest;
+        split(larger, id, rest, found, right);
+        left = join(smaller, aTiger, rest);
+    }
+}
+
+// unites a tree with a batch tree: splits the tree at the batch root, unites both halves with the batch subtrees and
+// joins the results around the batch root. a batch tiger whose id is already in the tree is freed and the tree's tiger
+// is kept. adds the # of batch tigers that went in to added
+Tiger *Streak::unite(Tiger *aTiger, Tiger *batch, int &added, FreeList &freed){
+    if (batch == nullptr){
         return aTiger;
-    }else if (aTiger->getRight() && aTiger->getRight()->getID() == id){
-        aTiger->setRight(nullptr);
+    }
+    if (aTiger == nullptr){
+        added += batch->m_size;
+        return batch;
+    }
+    Tiger *batchLeft = batch->getLeft();
+    Tiger *batchRight = batch->getRight();
+    Tiger *left;
+    Tiger *found;
+    Tiger *right;
+    split(aTiger, batch->getID(), left, found, right);
+    left = unite(left, batchLeft, added, freed);
+    right = unite(right, batchRight, added, freed);
+    Tiger *pivot = batch;
+    if (found != nullptr){
+        freed.push(batch);
+        pivot = found;
+    }else{
+        added++;
+    }
+    return join(left, pivot, right);
+}
+
+// intersects a tree with another one the same way: splits the tree at the other root and recurses on both halves. a
+// tiger of the tree survives only if the other tree has its id, every tiger of the other tree is freed. adds the # of
+// tigers of the tree that were freed to removed
+Tiger *Streak::intersect(Tiger *aTiger, Tiger *other, int &removed, FreeList &freed){
+    if (aTiger == nullptr){
+        freed.pushTree(other);
+        return nullptr;
+    }
+    if (other == nullptr){
+        removed += aTiger->m_size;
+        freed.pushTree(aTiger);
+        return nullptr;
+    }
+    Tiger *otherLeft = other->getLeft();
+    Tiger *otherRight = other->getRight();
+    Tiger *left;
+    Tiger *found;
+    Tiger *right;
+    split(aTiger, other->getID(), left, found, right);
+    freed.push(other);
+    left = intersect(left, otherLeft, removed, freed);
+    right = intersect(right, otherRight, removed, freed);
+    if (found != nullptr){
+        return join(left, found, right);
+    }
+    return join(left, right);
+}
+
+// subtracts another tree from a tree: a tiger of the tree survives only if the other tree does not have its id. every
+// tiger of the other tree is freed. adds the # of tigers of the tree that were freed to removed
+Tiger *Streak::subtract(Tiger *aTiger, Tiger *other, int &removed, FreeList &freed){
+    if (aTiger == nullptr){
+        freed.pushTree(other);
+        return nullptr;
+    }
+    if (other == nullptr){
         return aTiger;
-    }else if (aTiger->getID() < id){
-        return removeHelper(id, aTiger->getRight());
     }
-    else{
-        return removeHelper(id, aTiger->getLeft());
+    Tiger *otherLeft = other->getLeft();
+    Tiger *otherRight = other->getRight();
+    Tiger *left;
+    Tiger *found;
+    Tiger *right;
+    split(aTiger, other->getID(), left, found, right);
+    freed.push(other);
+    left = subtract(left, otherLeft, removed, freed);
+    right = subtract(right, otherRight, removed, freed);
+    if (found != nullptr){
+        freed.push(found);
+        removed++;
     }
+    return join(left, right);
 }
 
-void Streak::removeRebalance(int id, Tiger *aTiger) {
-    if (aTiger->getID() == id){
-        updateHeight(aTiger);
-    }else if (aTiger->getID() < id){
-        removeRebalance(id, aTiger->getRight());
-        updateHeight(aTiger->getRight());
-        aTiger->setRight(rebalance(aTiger->getRight()));
+// detaches the tiger with the largest id into max and rebalances on the way back up
+Tiger *Streak::removeMax(Tiger *aTiger, Tiger *&max){
+    if (aTiger->getRight() == nullptr){
+        max = aTiger;
+        return aTiger->getLeft();
+    }
+    aTiger->setRight(removeMax(aTiger->getRight(), max));
+    Balance::update(aTiger);
+    return Balance::rebalance(aTiger);
+}
+
+// joins two trees without a pivot, every id in left < every id in right. the largest tiger of left becomes the pivot
+Tiger *Streak::join(Tiger *left, Tiger *right){
+    if (left == nullptr){
+        return right;
+    }
+    Tiger *max;
+    left = removeMax(left, max);
+    return join(left, max, right);
+}
+
+// takes the tree out of other and leaves other empty. the tigers stay where they are, so other's pool is merged into
+// ours and other starts over with a pool of its own
+Tiger *Streak::takeTree(Streak& other){
+    Tiger *tree = other.m_root;
+    other.m_root = nullptr;
+    TigerPool &ours = pool();
+    TigerPool &theirs = other.pool();
+    if (&ours != &theirs){
+        ours.merge(theirs, m_pool);
+    }
+    ours.m_streaks--;
+    other.m_pool = make_shared<TigerPool>();
+    return tree;
+}
+
+int Streak::unite(Streak& other){
+    if (&other == this){
+        return 0;
+    }
+    int added = 0;
+    FreeList freed;
+    recordInserts(other.m_root);
+    m_root = unite(m_root, takeTree(other), added, freed);
+    deallocate(freed);
+    other.compactJournal();
+    return added;
+}
+
+int Streak::intersect(Streak& other){
+    if (&other == this){
+        return 0;
+    }
+    int removed = 0;
+    FreeList freed;
+    recordRemoves(m_root, other.m_root, false);
+    m_root = intersect(m_root, takeTree(other), removed, freed);
+    deallocate(freed);
+    other.compactJournal();
+    return removed;
+}
+
+int Streak::subtract(Streak& other){
+    int removed = size();
+    if (&other == this){
+        clear();
+        return removed;
+    }
+    removed = 0;
+    FreeList freed;
+    recordRemoves(other.m_root, m_root, true);
+    m_root = subtract(m_root, takeTree(other), removed, freed);
+    deallocate(freed);
+    other.compactJournal();
+    return removed;
+}
+
+int Streak::unite(Streak& other, TaskPool& tasks){
+    if (&other == this){
+        return 0;
+    }
+    int added = 0;
+    FreeList freed;
+    recordInserts(other.m_root);
+    m_root = unite(m_root, takeTree(other), added, freed, tasks);
+    deallocate(freed);
+    other.compactJournal();
+    return added;
+}
+
+int Streak::intersect(Streak& other, TaskPool& tasks){
+    if (&other == this){
+        return 0;
+    }
+    int removed = 0;
+    FreeList freed;
+    recordRemoves(m_root, other.m_root, false);
+    m_root = intersect(m_root, takeTree(other), removed, freed, tasks);
+    deallocate(freed);
+    other.compactJournal();
+    return removed;
+}
+
+int Streak::subtract(Streak& other, TaskPool& tasks){
+    int removed = size();
+    if (&other == this){
+        clear();
+        return removed;
+    }
+    removed = 0;
+    FreeList freed;
+    recordRemoves(other.m_root, m_root, true);
+    m_root = subtract(m_root, takeTree(other), removed, freed, tasks);
+    deallocate(freed);
+    other.compactJournal();
+    return removed;
+}
+
+// the parallel set operations split at the other root like the sequential ones, then hand the right halves to another
+// thread and do the left halves themselves. every task counts and frees into its own variables, which are added up
+// after the wait. once both trees together are below PARALLELCUTOFF a task is not worth it
+Tiger *Streak::unite(Tiger *aTiger, Tiger *batch, int &added, FreeList &freed, TaskPool &tasks){
+    if (aTiger == nullptr || batch == nullptr || aTiger->m_size + batch->m_size < PARALLELCUTOFF){
+        return unite(aTiger, batch, added, freed);
+    }
+    Tiger *batchLeft = batch->getLeft();
+    Tiger *batchRight = batch->getRight();
+    Tiger *left;
+    Tiger *found;
+    Tiger *right;
+    split(aTiger, batch->getID(), left, found, right);
+    int rightAdded = 0;
+    FreeList rightFreed;
+    TaskPool::Task task;
+    task.m_work = [&]{right = unite(right, batchRight, rightAdded, rightFreed, tasks);};
+    tasks.fork(task);
+    left = unite(left, batchLeft, added, freed, tasks);
+    tasks.wait(task);
+    added += rightAdded;
+    freed.append(rightFreed);
+    Tiger *pivot = batch;
+    if (found != nullptr){
+        freed.push(batch);
+        pivot = found;
     }else{
-        removeRebalance(id, aTiger->getLeft());
-        updateHeight(aTiger->getLeft());
-        aTiger->setLeft(rebalance(aTiger->getLeft()));
+        added++;
+    }
+    return join(left, pivot, right);
+}
+
+Tiger *Streak::intersect(Tiger *aTiger, Tiger *other, int &removed, FreeList &freed, TaskPool &tasks){
+    if (aTiger == nullptr || other == nullptr || aTiger->m_size + other->m_size < PARALLELCUTOFF){
+        return intersect(aTiger, other, removed, freed);
+    }
+    Tiger *otherLeft = other->getLeft();
+    Tiger *otherRight = other->getRight();
+    Tiger *left;
+    Tiger *found;
+    Tiger *right;
+    split(aTiger, other->getID(), left, found, right);
+    freed.push(other);
+    int rightRemoved = 0;
+    FreeList rightFreed;
+    TaskPool::Task task;
+    task.m_work = [&]{right = intersect(right, otherRight, rightRemoved, rightFreed, tasks);};
+    tasks.fork(task);
+    left = intersect(left, otherLeft, removed, freed, tasks);
+    tasks.wait(task);
+    removed += rightRemoved;
+    freed.append(rightFreed);
+    if (found != nullptr){
+        return join(left, found, right);
+    }
+    return join(left, right);
+}
+
+Tiger *Streak::subtract(Tiger *aTiger, Tiger *other, int &removed, FreeList &freed, TaskPool &tasks){
+    if (aTiger == nullptr || other == nullptr || aTiger->m_size + other->m_size < PARALLELCUTOFF){
+        return subtract(aTiger, other, removed, freed);
+    }
+    Tiger *otherLeft = other->getLeft();
+    Tiger *otherRight = other->getRight();
+    Tiger *left;
+    Tiger *found;
+    Tiger *right;
+    split(aTiger, other->getID(), left, found, right);
+    freed.push(other);
+    int rightRemoved = 0;
+    FreeList rightFreed;
+    TaskPool::Task task;
+    task.m_work = [&]{right = subtract(right, otherRight, rightRemoved, rightFreed, tasks);};
+    tasks.fork(task);
+    left = subtract(left, otherLeft, removed, freed, tasks);
+    tasks.wait(task);
+    removed += rightRemoved;
+    freed.append(rightFreed);
+    if (found != nullptr){
+        freed.push(found);
+        removed++;
+    }
+    return join(left, right);
+}
+
+void Streak::FreeList::push(Tiger *aTiger){
+    aTiger->setLeft(m_first);
+    if (m_first == nullptr){
+        m_last = aTiger;
+    }
+    m_first = aTiger;
+}
+
+// post order, so the children are read before push overwrites m_left
+void Streak::FreeList::pushTree(Tiger *aTiger){
+    if (aTiger != nullptr){
+        pushTree(aTiger->getLeft());
+        pushTree(aTiger->getRight());
+        push(aTiger);
+    }
+}
+
+void Streak::FreeList::append(FreeList &other){
+    if (other.m_first == nullptr){
+        return;
+    }
+    if (m_first == nullptr){
+        m_first = other.m_first;
+    }else{
+        m_last->setLeft(other.m_first);
+    }
+    m_last = other.m_last;
+}
+
+void Streak::deallocate(FreeList &freed){
+    pool().deallocate(freed.m_first, freed.m_last);
+}
+
+// right shares our pool from now on, so its tigers can be handed over without copying them
+void Streak::split(int id, Streak& right){
+    if (&right == this){
+        return;
+    }
+    right.clearTree();
+    right.pool().m_streaks--;
+    right.m_pool = m_pool;
+    pool().m_streaks++;
+    Tiger *found;
+    Tiger *larger;
+    split(m_root, id, m_root, found, larger);
+    if (found != nullptr){
+        larger = join(nullptr, found, larger);
+    }
+    recordRemoves(larger, nullptr, false);
+    right.m_root = larger;
+    right.compactJournal();
+}
+
+bool Streak::join(Streak& right){
+    if (&right == this){
+        return false;
+    }
+    if (m_root != nullptr && right.m_root != nullptr && select(size() - 1) >= right.select(0)){
+        return false;
+    }
+    recordInserts(right.m_root);
+    Tiger *tree = takeTree(right);
+    m_root = join(m_root, tree);
+    right.compactJournal();
+    return true;
+}
+
+bool Streak::join(const Tiger& pivot, Streak& right){
+    if (&right == this || pivot.getID() < MINID || pivot.getID() > MAXID){
+        return false;
+    }
+    if ((m_root != nullptr && select(size() - 1) >= pivot.getID())
+        || (right.m_root != nullptr && right.select(0) <= pivot.getID())){
+        return false;
+    }
+    recordInserts(right.m_root);
+    if (m_journal != nullptr){
+        m_journal->record(INSERTRECORD, pivot.getID(), packAttrs(pivot.getAge(), pivot.getGender(), pivot.getState()));
     }
+    Tiger *tree = takeTree(right);
+    m_root = join(m_root, pool().allocate(pivot), tree);
+    right.compactJournal();
+    return true;
 }
 
-// deletes dead tiger
-void Streak::deadTiger(int id) {
-    if (id >= MINID && id <= MAXID){
-        remove(id);
-        findDead(m_root);
+// builds a perfectly balanced tree out of the first n tigers of a list linked through m_right and advances the list
+// past them. no nodes are allocated, the middle tiger of every range becomes the root of that range
+Tiger *Streak::buildBalanced(Tiger *&list, int n) {
+    if (n <= 0){
+        return nullptr;
     }
+    Tiger *left = buildBalanced(list, n / 2);
+    Tiger *root = list;
+    list = list->getRight();
+    root->setLeft(left);
+    root->setRight(buildBalanced(list, n - n / 2 - 1));
+    Balance::update(root);
+    return root;
 }
 
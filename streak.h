@@ -1,29 +1,62 @@
 #ifndef STREAK_H
 #define STREAK_H
 #include <iostream>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "avltree.h"
 using namespace std;
 class Tester; 
 class STREAK;
 enum STATE {ALIVE, DEAD};
 enum AGE {CUB, YOUNG, OLD};
 enum GENDER {MALE, FEMALE, UNKNOWN};
+enum RESULT {INSERTED, DUPLICATE, OUTOFRANGE};
 const int MINID = 10000;
 const int MAXID = 99999;
+// parallel set operations do two trees of fewer tigers than this together on one thread
+const int PARALLELCUTOFF = 4096;
+// the binary snapshot written by Streak::save, all fields little endian:
+//   magic "STRK", u16 version, u16 zero, u32 count,
+//   count ids as LEB128 varints, each the difference to the id before it (the first one to MINID - 1),
+//   count attribute bytes (age | gender << 2 | state << 4) in the same order,
+//   u32 crc32 of everything before it
+const uint32_t SNAPSHOTMAGIC = 0x4B525453;
+const uint16_t SNAPSHOTVERSION = 1;
+const int SNAPSHOTHEADER = 12;
 #define DEFAULT_HEIGHT 0
 #define DEFAULT_ID 0
 #define DEFAULT_STATE ALIVE
 #define DEFAULT_AGE CUB
 #define DEFAULT_GENDER UNKNOWN
 
+// packs and unpacks age, gender and state into one byte, for compact nodes and bulk loading
+inline uint8_t packAttrs(AGE age, GENDER gender, STATE state){
+    return static_cast<uint8_t>(age | (gender << 2) | (state << 4));
+}
+inline AGE unpackAge(uint8_t attrs){return static_cast<AGE>(attrs & 3);}
+inline GENDER unpackGender(uint8_t attrs){return static_cast<GENDER>((attrs >> 2) & 3);}
+inline STATE unpackState(uint8_t attrs){return static_cast<STATE>((attrs >> 4) & 1);}
+// returns true if attrs is a byte packAttrs can make
+inline bool validAttrs(uint8_t attrs){
+    return (attrs & 3) <= OLD && ((attrs >> 2) & 3) <= UNKNOWN && (attrs >> 5) == 0;
+}
+// the CRC-32 of the snapshot files (IEEE polynomial, as zlib), crc continues an earlier call over the bytes before
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0);
+
 class Tiger{
 public:
     friend class Tester;
     friend class Streak;
+    friend class TigerPool;
+    friend struct TigerCounts;
+    template <class Node, class Augment> friend class AvlBalance;
     Tiger(int id, AGE age = DEFAULT_AGE, GENDER gender = DEFAULT_GENDER, STATE state = DEFAULT_STATE)
             :m_id(id),m_age(age),m_gender(gender),m_state(state) {
         m_left = nullptr;
         m_right = nullptr;
         m_height = DEFAULT_HEIGHT;
+        resetCounts();
     }
     Tiger(){
         m_id = DEFAULT_ID;
@@ -33,6 +66,7 @@ public:
         m_left = nullptr;
         m_right = nullptr;
         m_height = DEFAULT_HEIGHT;
+        resetCounts();
     }
     int getID() const {return m_id;}
     STATE getState() const {return m_state;}
@@ -89,47 +123,217 @@ private:
     Tiger* m_left;//the pointer to the left child in the BST
     Tiger* m_right;//the pointer to the right child in the BST
     int m_height;//the height of node in the BST
+    int m_ages[3];//number of tigers of each AGE in the subtree rooted here
+    int m_genders[3];//number of tigers of each GENDER in the subtree rooted here
+    int m_states[2];//number of tigers of each STATE in the subtree rooted here
+    int m_size;//number of tigers in the subtree rooted here
+
+    // counts only this tiger, as if it were a leaf
+    void resetCounts(){
+        for (int i = 0; i < 3; i++){
+            m_ages[i] = 0;
+            m_genders[i] = 0;
+        }
+        m_states[ALIVE] = 0;
+        m_states[DEAD] = 0;
+        m_size = 1;
+        m_ages[m_age]++;
+        m_genders[m_gender]++;
+        m_states[m_state]++;
+    }
+};
+
+// the augmentation of a Streak: the subtree size and the per subtree AGE/GENDER/STATE counts of every tiger
+struct TigerCounts{
+    static void update(Tiger *aTiger);
+};
+
+// hands out Tiger nodes from slabs of SLABSIZE tigers. removed tigers go on a free list (linked through m_left) and are
+// reused first, and every tiger can be given back at once by releasing or resetting the slabs. streaks that move nodes
+// between each other share one pool: a pool merged into another forwards to it and its slabs move along
+const int SLABSIZE = 1024;
+class TigerPool{
+public:
+    friend class Streak;
+    TigerPool();
+    ~TigerPool();
+    Tiger *allocate(const Tiger& tiger);// returns a new leaf with the tiger's id, age, gender and state
+    void deallocate(Tiger *aTiger);// puts one tiger on the free list
+    void deallocate(Tiger *first, Tiger *last);// puts a list of tigers linked through m_left on the free list
+    void release();// frees every slab, every tiger handed out becomes invalid
+    void reset();// keeps the slabs for reuse, every tiger handed out becomes invalid
+    void merge(TigerPool &other, const shared_ptr<TigerPool> &self);// takes over other's slabs, other forwards here
+private:
+    struct Slab{
+        Slab *m_next;
+        alignas(Tiger) unsigned char m_tigers[SLABSIZE * sizeof(Tiger)];
+    };
+    Slab *m_first;//the first slab, slabs are kept in the order they were allocated
+    Slab *m_current;//the slab new tigers are carved from
+    int m_used;//number of tigers carved from m_current
+    Tiger *m_free;//tigers given back, linked through m_left
+    Slab *m_merged;//slabs taken over from merged pools, their tigers are reused through the free list only
+    int m_streaks;//number of streaks drawing from this pool, slabs can only be dropped at once when it is 1
+    shared_ptr<TigerPool> m_forward;//the pool this one was merged into, nullptr if it was not
+
+    static void freeSlabs(Slab *slab);
 };
 
+class TaskPool;
+class StreakView;
+class StreakJournal;
+struct CompactTiger;
+
 class Streak{
 public:
     friend class Tester;
     Streak();
+    // builds a streak out of a batch of tigers, same result as inserting them one by one but in O(n)
+    template <class InputIt>
+    Streak(InputIt first, InputIt last) : Streak(){
+        build(first, last);
+    }
+    // copies every tiger into a pool of its own, O(n). a ConcurrentStreak snapshot is the O(1) way to keep a state
+    Streak(const Streak& other);
+    Streak& operator=(const Streak& other);
     ~Streak();
-    void insert(const Tiger& tiger);
-    void clear();
-    void remove(int id);
+    RESULT insert(const Tiger& tiger);// inserts in one descent, reports duplicates/out of range ids
+    void clear(bool keepSlab = false);// frees every tiger at once, keepSlab keeps the memory for later inserts
+    // replaces the contents with a batch of tigers in O(n). out of range ids are dropped and of several tigers with the
+    // same id the first one wins, like insert. returns the # of tigers in the streak
+    template <class InputIt>
+    int build(InputIt first, InputIt last);
+    // inserts a batch of tigers with the same rules as insert, by merging the sorted batch into the tree in
+    // O(m*log(n/m + 1)). returns the # of tigers inserted
+    int insertBatch(const vector<Tiger>& tigers);
+    // set operations that move the tigers of other into this streak instead of copying them, other is left empty.
+    // where both streaks have a tiger with the same id, this streak's tiger is kept. O(m*log(n/m + 1))
+    int unite(Streak& other);// adds other's tigers, returns the # added
+    int intersect(Streak& other);// keeps only the ids other also has, returns the # removed
+    int subtract(Streak& other);// removes the ids other has, returns the # removed
+    // the same set operations run as fork-join tasks on a thread pool, each split at a root hands one half to another
+    // thread. below a few thousand tigers the halves are done sequentially
+    int unite(Streak& other, TaskPool& tasks);
+    int intersect(Streak& other, TaskPool& tasks);
+    int subtract(Streak& other, TaskPool& tasks);
+    void split(int id, Streak& right);// keeps the ids smaller than id and moves the rest into right, O(log n)
+    // appends right to this streak, every id in right has to be larger than every id here (and than pivot's id).
+    // returns false and changes nothing if they are not. O(log n)
+    bool join(Streak& right);
+    bool join(const Tiger& pivot, Streak& right);
+    bool remove(int id);// returns false if the id is not in the tree
     void dumpTree() const;
     void listTigers() const;
     bool setState(int id, STATE state);
-    void removeDead();//remove all dead tigers from the tree
+    int removeDead();//remove all dead tigers from the tree, returns how many were removed
     bool findTiger(int id) const;//returns true if the tiger is in tree
     int countTigerCubs() const;// returns the # of cubs in the streak
+    int countBy(AGE age) const;// returns the # of tigers with this age, O(1)
+    int countBy(GENDER gender) const;// returns the # of tigers with this gender, O(1)
+    int countBy(STATE state) const;// returns the # of tigers with this state, O(1)
+    int size() const;// returns the # of tigers in the streak, O(1)
+    int rank(int id) const;// returns the # of tigers with an id smaller than id
+    int select(int k) const;// returns the id of the k-th smallest tiger (0-based), DEFAULT_ID if k is out of range
+    int countInRange(int lo, int hi) const;// returns the # of tigers with lo <= id <= hi, O(log n)
+    // copies the tigers into an immutable StreakView laid out for fast lookups, O(n)
+    StreakView freezeView() const;
+    // writes the tigers as a binary snapshot (see SNAPSHOTMAGIC). the file is written and synced next to path, then
+    // renamed over it, so an old snapshot stays whole if writing fails. returns false if it could not be written
+    bool save(const string &path) const;
+    // replaces the contents with a snapshot written by save, built in O(n) without a single insert. returns false and
+    // leaves the streak as it was if the file can not be read, is of another version or fails the checksum
+    bool load(const string &path);
+    // writes the tigers as a tree image a MappedStreak can map and query in place (see IMAGEMAGIC), O(n). written
+    // next to path and renamed over it like save, returns false if the file could not be written
+    bool saveImage(const string &path) const;
+    // from now on every insert, remove, setState and removeDead that changes the streak is recorded in journal, so is
+    // every tiger insertBatch, the set operations, split and join add or take away, and every update that replaces
+    // the whole tree compacts it. nullptr stops all of it. StreakJournal::recover attaches itself
+    void attach(StreakJournal *journal);
+    // calls visitor(const Tiger&) on every tiger with lo <= id <= hi in increasing id order, O(log n + k)
+    template <class Visitor>
+    void forEachInRange(int lo, int hi, Visitor &&visitor) const{
+        forEachInRange(lo, hi, visitor, m_root);
+    }
 private:
     Tiger* m_root;//the root of the BST
+    shared_ptr<TigerPool> m_pool;//every tiger in the tree lives in this pool, or in the pool it forwards to
+    StreakJournal *m_journal;//records the updates, nullptr if no journal is attached
+
+    // tigers freed by a set operation, linked through m_left. they go back to the pool once the operation is done, so
+    // parallel tasks never touch the pool
+    struct FreeList{
+        Tiger *m_first = nullptr;
+        Tiger *m_last = nullptr;
+        void push(Tiger *aTiger);
+        void pushTree(Tiger *aTiger);
+        void append(FreeList &other);
+    };
+
+    typedef AvlBalance<Tiger, TigerCounts> Balance;//the balancing, shared with AvlTree
 
     void dump(Tiger* aTiger) const;//helper for recursive traversal
-    void updateHeight(Tiger* aTiger);
-    int checkImbalance(Tiger* aTiger);
-    Tiger* rebalance(Tiger* aTiger);
-    void clear(Tiger* aTiger);
+    TigerPool &pool();
+    Tiger *takeTree(Streak& other);
+    void clear(Tiger *aTiger);
+    void clearTree(bool keepSlab = false);// clear without compacting the journal, for the updates that go on to refill
+    bool compactJournal();
+    void recordInserts(Tiger *aTiger);
+    void recordRemoves(Tiger *aTiger, Tiger *other, bool inOther);
+    template <class Visitor>
+    void forEachInRange(int lo, int hi, Visitor &visitor, Tiger *aTiger) const;
     bool duplicates(int, Tiger *aTiger) const;
-    void insert(const Tiger& tiger, Tiger *&aTiger);
-    Tiger* singleLeft(Tiger *aTiger);
-    Tiger* singleRight(Tiger *aTiger);
-    Tiger* leftRight(Tiger *aTiger);
-    Tiger* rightLeft(Tiger *aTiger);
-    void remove(int id, Tiger *&aTiger);
-    void assignTiger(int, Tiger *aTiger, Tiger *secondTiger);
     Tiger *getTiger(int id);
+    bool remove(int id, int &visits);// remove, counting the nodes it visited for the tests
     Tiger *getTigerHelper(int id, Tiger *aTiger);
-    Tiger *minTigerParent(Tiger *aTiger);
-    void twoChildrenRemove(Tiger *parent, Tiger *toDelete);
     void listTigers(Tiger *aTiger) const;
-    void findDead(Tiger *aTiger);
-    void countTigerCubs(int&, Tiger *aTiger) const;
-    Tiger *removeHelper(int, Tiger *aTiger);
-    void removeRebalance(int, Tiger *aTiger);
-    void deadTiger(int);
+    Tiger *filterDead(Tiger *aTiger, Tiger *list, int &kept, int &removed);
+    Tiger *buildBalanced(Tiger *&list, int n);
+    int build(vector<uint32_t> &batch);
+    Tiger *buildBatch(vector<uint32_t> &batch, int &count, bool sorted = false);
+    static uint32_t linkImage(vector<CompactTiger> &nodes, int lo, int hi);
+    static uint32_t pack(const Tiger& tiger);
+    static void sortBatch(vector<uint32_t> &batch);
+    Tiger *join(Tiger *left, Tiger *pivot, Tiger *right);
+    void split(Tiger *aTiger, int id, Tiger *&left, Tiger *&found, Tiger *&right);
+    void deallocate(FreeList &freed);
+    Tiger *unite(Tiger *aTiger, Tiger *batch, int &added, FreeList &freed);
+    Tiger *intersect(Tiger *aTiger, Tiger *other, int &removed, FreeList &freed);
+    Tiger *subtract(Tiger *aTiger, Tiger *other, int &removed, FreeList &freed);
+    Tiger *unite(Tiger *aTiger, Tiger *batch, int &added, FreeList &freed, TaskPool &tasks);
+    Tiger *intersect(Tiger *aTiger, Tiger *other, int &removed, FreeList &freed, TaskPool &tasks);
+    Tiger *subtract(Tiger *aTiger, Tiger *other, int &removed, FreeList &freed, TaskPool &tasks);
+    Tiger *removeMax(Tiger *aTiger, Tiger *&max);
+    Tiger *join(Tiger *left, Tiger *right);
 };
+
+// packs every tiger in range as (id - MINID) << 8 | attrs, so the batch can be radix sorted on the 17 id bits
+template <class InputIt>
+int Streak::build(InputIt first, InputIt last){
+    vector<uint32_t> batch;
+    for (; first != last; ++first){
+        const Tiger &tiger = *first;
+        if (tiger.getID() >= MINID && tiger.getID() <= MAXID){
+            batch.push_back(pack(tiger));
+        }
+    }
+    return build(batch);
+}
+
+// in order traversal that skips every subtree outside [lo, hi]. recurses to the left and loops to the right, so only
+// subtrees that can hold ids in range are entered
+template <class Visitor>
+void Streak::forEachInRange(int lo, int hi, Visitor &visitor, Tiger *aTiger) const{
+    while (aTiger != nullptr){
+        if (aTiger->m_id < lo){
+            aTiger = aTiger->m_right;
+        }else if (aTiger->m_id > hi){
+            aTiger = aTiger->m_left;
+        }else{
+            forEachInRange(lo, hi, visitor, aTiger->m_left);
+            visitor(static_cast<const Tiger&>(*aTiger));
+            aTiger = aTiger->m_right;
+        }
+    }
+}
 #endif
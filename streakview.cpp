@@ -0,0 +1,72 @@
+#include "streakview.h"
+
+StreakView::StreakView(){
+    m_ids.assign(1, DEFAULT_ID);
+    m_attrs.assign(1, 0);
+    m_ranks.assign(1, 0);
+}
+
+// fills the slots in order of an in order traversal of the implicit tree, which hands out the sorted tigers in order
+StreakView::StreakView(const vector<uint32_t> &sorted){
+    m_ids.resize(sorted.size() + 1);
+    m_attrs.resize(sorted.size() + 1);
+    m_ranks.resize(sorted.size() + 1);
+    m_ids[0] = DEFAULT_ID;
+    m_attrs[0] = 0;
+    m_ranks[0] = sorted.size();
+    size_t next = 0;
+    layout(sorted, next, 1);
+}
+
+bool StreakView::findTiger(int id) const{
+    return m_ids[lowerBound(id)] == id && id != DEFAULT_ID;
+}
+
+bool StreakView::getTiger(int id, Tiger &tiger) const{
+    int slot = lowerBound(id);
+    if (slot == 0 || m_ids[slot] != id){
+        return false;
+    }
+    uint8_t attrs = m_attrs[slot];
+    tiger = Tiger(id, unpackAge(attrs), unpackGender(attrs), unpackState(attrs));
+    return true;
+}
+
+// the ranks of the first ids past hi and from lo. slot 0 stands for past the end and ranks as the size
+int StreakView::countInRange(int lo, int hi) const{
+    if (lo > hi){
+        return 0;
+    }
+    int upper = hi >= MAXID ? 0 : lowerBound(hi + 1);
+    return m_ranks[upper] - m_ranks[lowerBound(lo)];
+}
+
+int StreakView::size() const{
+    return m_ranks[0];
+}
+
+// descends the implicit tree going right whenever the slot holds a smaller id, so the path ends past a leaf. the slot
+// where it last went left holds the lower bound: shifting out the trailing right turns and the final left turn gets
+// back there. 16 slots of one cache line are four levels down, they are prefetched every step
+int StreakView::lowerBound(int id) const{
+    const int *ids = m_ids.data();
+    size_t n = m_ids.size() - 1;
+    size_t slot = 1;
+    while (slot <= n){
+        __builtin_prefetch(ids + slot * 16);
+        slot = 2 * slot + (ids[slot] < id);
+    }
+    slot >>= __builtin_ffsll(~slot);
+    return slot;
+}
+
+void StreakView::layout(const vector<uint32_t> &sorted, size_t &next, size_t slot){
+    if (slot < m_ids.size()){
+        layout(sorted, next, 2 * slot);
+        m_ids[slot] = (sorted[next] >> 8) + MINID;
+        m_attrs[slot] = sorted[next] & 0xff;
+        m_ranks[slot] = next;
+        next++;
+        layout(sorted, next, 2 * slot + 1);
+    }
+}
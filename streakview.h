@@ -0,0 +1,28 @@
+#ifndef STREAKVIEW_H
+#define STREAKVIEW_H
+#include "streak.h"
+#include <cstdint>
+#include <vector>
+
+// an immutable copy of a streak laid out for lookups, made by Streak::freezeView. the ids are stored in Eytzinger
+// order, the breadth first order of a complete tree in one array where the children of slot k are 2k and 2k+1. the
+// first levels share a few cache lines, and a lookup is a fixed loop of compares with no branch on the result, which
+// prefetches the slots four levels further down while it works. the view does not change when the streak does
+class StreakView{
+public:
+    friend class Tester;
+    StreakView();
+    explicit StreakView(const vector<uint32_t> &sorted);// tigers packed by Streak, sorted by id
+    bool findTiger(int id) const;//returns true if the tiger is in the view
+    bool getTiger(int id, Tiger &tiger) const;//copies the tiger with this id into tiger, returns false if there is none
+    int countInRange(int lo, int hi) const;// returns the # of tigers with lo <= id <= hi, O(log n)
+    int size() const;
+private:
+    vector<int> m_ids;//the ids in Eytzinger order, m_ids[0] is unused
+    vector<uint8_t> m_attrs;//age | gender << 2 | state << 4 of the tiger in the same slot
+    vector<int> m_ranks;//the # of smaller ids of the tiger in the same slot, m_ranks[0] is the size
+
+    int lowerBound(int id) const;// slot of the smallest id >= id, 0 if there is none
+    void layout(const vector<uint32_t> &sorted, size_t &next, size_t slot);
+};
+#endif
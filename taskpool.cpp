@@ -0,0 +1,76 @@
+#include "taskpool.h"
+
+TaskPool::TaskPool(int threads){
+    if (threads <= 0){
+        threads = thread::hardware_concurrency();
+    }
+    m_stopping = false;
+    for (int i = 1; i < threads; i++){
+        m_workers.emplace_back(&TaskPool::work, this);
+    }
+}
+
+// lets the workers finish and joins them. every forked task has been waited for by now
+TaskPool::~TaskPool(){
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_ready.notify_all();
+    for (thread &worker : m_workers){
+        worker.join();
+    }
+}
+
+int TaskPool::threads() const{
+    return m_workers.size() + 1;
+}
+
+void TaskPool::fork(Task &task){
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_queue.push_back(&task);
+    }
+    m_ready.notify_all();
+}
+
+// the newest task is most likely the one waited for, or one of its children, so the waiting thread takes from the back
+void TaskPool::wait(Task &task){
+    unique_lock<mutex> lock(m_mutex);
+    while (!task.m_done.load(memory_order_acquire)){
+        if (!m_queue.empty()){
+            Task *next = m_queue.back();
+            m_queue.pop_back();
+            lock.unlock();
+            run(next);
+            lock.lock();
+        }else{
+            m_ready.wait(lock);
+        }
+    }
+}
+
+void TaskPool::work(){
+    unique_lock<mutex> lock(m_mutex);
+    while (true){
+        m_ready.wait(lock, [this]{return m_stopping || !m_queue.empty();});
+        if (m_queue.empty()){
+            return;
+        }
+        Task *next = m_queue.front();
+        m_queue.pop_front();
+        lock.unlock();
+        run(next);
+        lock.lock();
+    }
+}
+
+// marks the task done under the lock, so a thread about to wait for it can not miss the signal
+void TaskPool::run(Task *task){
+    task->m_work();
+    {
+        lock_guard<mutex> lock(m_mutex);
+        task->m_done.store(true, memory_order_release);
+    }
+    m_ready.notify_all();
+}
@@ -0,0 +1,36 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+using namespace std;
+
+// a small fork-join thread pool. fork queues a task, wait runs queued tasks until the task it waits for is done, so a
+// thread waiting on its children keeps working instead of blocking, and nested forks can not run out of threads
+class TaskPool{
+public:
+    struct Task{
+        function<void()> m_work;
+        atomic<bool> m_done{false};
+    };
+    // starts threads - 1 workers, the thread that calls wait is the last one. 0 uses every core
+    explicit TaskPool(int threads = 0);
+    ~TaskPool();
+    int threads() const;// returns the # of threads working on tasks, the waiting thread included
+    void fork(Task &task);// queues a task, it has to stay alive until wait returns
+    void wait(Task &task);// returns once the task is done, running queued tasks meanwhile
+private:
+    vector<thread> m_workers;
+    deque<Task*> m_queue;//workers take the oldest task, waiting threads the newest
+    mutex m_mutex;
+    condition_variable m_ready;//signalled when a task is queued or done
+    bool m_stopping;
+
+    void work();
+    void run(Task *task);
+};
+#endif